@@ -70,9 +70,18 @@ namespace sure
         OctreeCenter[0] = OctreeCenter[1] = OctreeCenter[2] = 0.0;
         OctreeSmallestVoxelSize = 0.01;
         OctreeRootVoxelSize = 20.48;
-        OctreeMaximumNumberOfNodes = 500000;
+        OctreeMaximumNumberOfNodes = 100000;
+        OctreeConstruction = sure::MORTON_SORTED_INSERTION;
+        ReuseMemoryBetweenFrames = true;
+        SummedVolumeTableMaximumCells = 0;
+        NumberOfThreads = 0;
+        ScaleSpaceEntropy = false;
+        ApproximateEntropy = false;
+        CacheNeighborhoods = true;
+        OrganizedNormalEstimation = false;
         EntropyMode = sure::NORMALS;
         AdditionalPointsOnDepthBorders = true;
+        MaximumPointsOnDepthBorders = 0;
         IgnoreNormalsOnBackgroundDepthBorders = false;
         IgnoreBackgroundDetections = true;
         ImproveLocalization = true;
@@ -126,15 +135,42 @@ namespace sure
       // Octree edge length in meters
       Scalar OctreeRootVoxelSize;
 
-      // Number of allocated nodes for the octree.
+      // Number of nodes reserved for the octree. The node pool grows beyond it on demand.
       int OctreeMaximumNumberOfNodes;
 
+      // Specifies how the point cloud is inserted into the octree
+      OctreeConstructionMode OctreeConstruction;
+
+      // Keeps the octree node pool between calls and resets it in constant time instead of reallocating it
+      bool ReuseMemoryBetweenFrames;
+
+      // Maximum number of cells of a summed-volume table for integrating point moments in constant time. A value of zero disables the tables
+      int SummedVolumeTableMaximumCells;
+
+      // Number of worker threads for the parallel calculation stages. A value of zero uses all available threads
+      int NumberOfThreads;
+
+      // Integrates the normal histograms of all scales with a shared scale-space pyramid. Only used for entropy calculation with normals
+      bool ScaleSpaceEntropy;
+
+      // Evaluates the entropy with a vectorized approximation of the logarithm. The absolute error of the raw entropy stays below 1.5e-5 bits
+      bool ApproximateEntropy;
+
+      // Collects the neighborhoods of all nodes once per scale and shares them between the cornerness calculation and the maximum suppression
+      bool CacheNeighborhoods;
+
+      // Integrates the points for normals of organized point clouds with integral images where possible. Nodes near depth borders still use the octree
+      bool OrganizedNormalEstimation;
+
       // Specifies wether normals of cross-products are used for entropy calculation
       EntropyCalculationMode EntropyMode;
 
       // Additional points along the view direction are added at foreground depth borders
       bool AdditionalPointsOnDepthBorders;
 
+      // Maximum number of additional points on depth borders per point cloud. A value of zero disables the limit
+      int MaximumPointsOnDepthBorders;
+
       // Disables normal calculation on background depth borders
       bool IgnoreNormalsOnBackgroundDepthBorders;
 
@@ -187,6 +223,43 @@ namespace sure
           ar & ImproveLocalization;
 
           ar & Scales;
+
+          if( version >= 9 )
+          {
+            ar & OctreeConstruction;
+          }
+          if( version >= 10 )
+          {
+            ar & ReuseMemoryBetweenFrames;
+          }
+          if( version >= 11 )
+          {
+            ar & SummedVolumeTableMaximumCells;
+          }
+          if( version >= 12 )
+          {
+            ar & NumberOfThreads;
+          }
+          if( version >= 13 )
+          {
+            ar & ScaleSpaceEntropy;
+          }
+          if( version >= 14 )
+          {
+            ar & ApproximateEntropy;
+          }
+          if( version >= 15 )
+          {
+            ar & CacheNeighborhoods;
+          }
+          if( version >= 16 )
+          {
+            ar & MaximumPointsOnDepthBorders;
+          }
+          if( version >= 17 )
+          {
+            ar & OrganizedNormalEstimation;
+          }
       }
 
   };
@@ -36,7 +36,6 @@ sure::data::Map2d<Type>::Map2d()
 {
   defaultValue = Type();
   map = NULL;
-  valid = NULL;
   reset();
 }
 
@@ -45,7 +44,6 @@ sure::data::Map2d<Type>::Map2d(Type defaultValue)
 {
   this->defaultValue = defaultValue;
   map = NULL;
-  valid = NULL;
   reset();
 }
 
@@ -54,7 +52,6 @@ sure::data::Map2d<Type>::Map2d(unsigned int width, unsigned int height)
 {
   defaultValue = Type();
   map = NULL;
-  valid = NULL;
   resize(width, height);
 }
 
@@ -63,7 +60,6 @@ sure::data::Map2d<Type>::Map2d(unsigned int width, unsigned int height, Type def
 {
   this->defaultValue = defaultValue;
   map = NULL;
-  valid = NULL;
   resize(width, height);
 }
 
@@ -71,7 +67,6 @@ template<typename Type>
 sure::data::Map2d<Type>::Map2d(const sure::data::Map2d<Type>& obj)
 {
   this->map = NULL;
-  this->valid = NULL;
   this->operator=(obj);
 }
 
@@ -84,23 +79,17 @@ inline void sure::data::Map2d<Type>::reset()
     delete[] map;
     map = NULL;
   }
-  if( valid )
-  {
-    delete[] valid;
-    valid = NULL;
-  }
+  valid.reset();
 }
 
 template<typename Type>
 inline void sure::data::Map2d<Type>::clear()
 {
-  for(unsigned int i=0; i<size; ++i)
+  if( map )
   {
-    if( map )
-      map[i] = defaultValue;
-    if( valid )
-      valid[i] = false;
+    std::fill(map, map+size, defaultValue);
   }
+  valid.clear();
 }
 
 template<typename Type>
@@ -113,8 +102,8 @@ inline void sure::data::Map2d<Type>::resize(unsigned int width, unsigned int hei
   if( size > 0 )
   {
     map = new Type[size];
-    valid = new bool[size];
   }
+  valid.resize(width, height);
   clear();
 }
 
@@ -125,11 +114,8 @@ sure::data::Map2d<Type>& sure::data::Map2d<Type>::operator=(const sure::data::Ma
   {
     this->resize(rValue.width, rValue.height);
     this->defaultValue = rValue.defaultValue;
-    for(unsigned int i=0; i<size; ++i)
-    {
-      map[i] = rValue.map[i];
-      valid[i] = rValue.valid[i];
-    }
+    std::copy(rValue.map, rValue.map+size, map);
+    valid = rValue.valid;
   }
   return *this;
 }
@@ -158,22 +144,22 @@ inline Type& sure::data::Map2d<Type>::at(unsigned int index)
 template<typename Type>
 inline bool sure::data::Map2d<Type>::exists(unsigned int index) const
 {
-  if( index > size || !valid )
+  if( index > size )
   {
     return false;
   }
-  return valid[index];
+  return valid.at(index);
 }
 
 template<typename Type>
-inline bool& sure::data::Map2d<Type>::exists(unsigned int index)
+inline typename sure::data::Map2d<Type>::ValidityReference sure::data::Map2d<Type>::exists(unsigned int index)
 {
-  if( index > size || !valid )
+  if( index >= size )
   {
-    invalidStatus = false;
-    return invalidStatus;
+    invalidStatus = 0;
+    return ValidityReference(invalidStatus, 0);
   }
-  return valid[index];
+  return valid.at(index);
 }
 
 template<typename Type>
@@ -182,7 +168,7 @@ inline void sure::data::Map2d<Type>::set(unsigned int index, const Type& t)
   if( index < size )
   {
     map[index] = t;
-    valid[index] = true;
+    valid.at(index) = true;
   }
 }
 
@@ -192,7 +178,7 @@ inline void sure::data::Map2d<Type>::remove(unsigned int index)
   if( index < size )
   {
     map[index] = defaultValue;
-    valid[index] = false;
+    valid.at(index) = false;
   }
 }
 
@@ -228,7 +214,7 @@ std::vector<Type> sure::data::Map2d<Type>::getVector(bool onlyValid) const
   }
   for(int i=0; i<(int) size; ++i)
   {
-    if( onlyValid && valid[i] )
+    if( onlyValid && valid.at(i) )
     {
       newVector.push_back(map[i]);
     }
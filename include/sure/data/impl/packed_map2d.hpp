@@ -0,0 +1,221 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <cstring>
+
+namespace sure
+{
+  namespace data
+  {
+    //! Number of set bits
+    inline unsigned countBits(uint64_t word)
+    {
+#if defined(__GNUC__)
+      return __builtin_popcountll(word);
+#else
+      unsigned bits = 0;
+      for(; word; word &= word - 1)
+      {
+        bits++;
+      }
+      return bits;
+#endif
+    }
+
+    //! Position of the lowest set bit, word must not be zero
+    inline unsigned lowestBit(uint64_t word)
+    {
+#if defined(__GNUC__)
+      return __builtin_ctzll(word);
+#else
+      unsigned bit = 0;
+      for(; !(word & 1); word >>= 1)
+      {
+        bit++;
+      }
+      return bit;
+#endif
+    }
+  }
+}
+
+template<unsigned Bits>
+sure::data::PackedMap2d<Bits>::PackedMap2d()
+{
+  words = NULL;
+  reset();
+}
+
+template<unsigned Bits>
+sure::data::PackedMap2d<Bits>::PackedMap2d(unsigned int width, unsigned int height)
+{
+  words = NULL;
+  resize(width, height);
+}
+
+template<unsigned Bits>
+sure::data::PackedMap2d<Bits>::PackedMap2d(const sure::data::PackedMap2d<Bits>& obj)
+{
+  words = NULL;
+  this->operator=(obj);
+}
+
+template<unsigned Bits>
+inline void sure::data::PackedMap2d<Bits>::reset()
+{
+  width = height = size = numberOfWords = 0;
+  if( words )
+  {
+    delete[] words;
+    words = NULL;
+  }
+}
+
+template<unsigned Bits>
+inline void sure::data::PackedMap2d<Bits>::clear()
+{
+  if( words )
+  {
+    memset(words, 0, numberOfWords * sizeof(Word));
+  }
+}
+
+template<unsigned Bits>
+inline void sure::data::PackedMap2d<Bits>::resize(unsigned int width, unsigned int height)
+{
+  reset();
+  this->width = width;
+  this->height = height;
+  size = width*height;
+  numberOfWords = (size + VALUES_PER_WORD - 1) / VALUES_PER_WORD;
+  if( numberOfWords > 0 )
+  {
+    words = new Word[numberOfWords];
+  }
+  clear();
+}
+
+template<unsigned Bits>
+sure::data::PackedMap2d<Bits>& sure::data::PackedMap2d<Bits>::operator=(const sure::data::PackedMap2d<Bits>& rValue)
+{
+  if( this != &rValue )
+  {
+    this->resize(rValue.width, rValue.height);
+    if( numberOfWords > 0 )
+    {
+      memcpy(words, rValue.words, numberOfWords * sizeof(Word));
+    }
+  }
+  return *this;
+}
+
+template<unsigned Bits>
+inline unsigned sure::data::PackedMap2d<Bits>::at(unsigned int index) const
+{
+  if( index >= size )
+  {
+    return 0;
+  }
+  return (words[index / VALUES_PER_WORD] >> ((index % VALUES_PER_WORD) * Bits)) & VALUE_MASK;
+}
+
+template<unsigned Bits>
+inline void sure::data::PackedMap2d<Bits>::set(unsigned int index, unsigned value)
+{
+  if( index < size )
+  {
+    at(index) = value;
+  }
+}
+
+template<unsigned Bits>
+inline typename sure::data::PackedMap2d<Bits>::Word sure::data::PackedMap2d<Bits>::matches(Word word, unsigned value)
+{
+  // positions holding value become zero, a position is zero if none of its bits is set
+  Word difference = word ^ (LOW_BITS * (Word(value) & VALUE_MASK));
+  Word nonZero = difference;
+  for(unsigned i=1; i<Bits; ++i)
+  {
+    nonZero |= difference >> i;
+  }
+  return ~nonZero & LOW_BITS;
+}
+
+template<unsigned Bits>
+inline typename sure::data::PackedMap2d<Bits>::Word sure::data::PackedMap2d<Bits>::usedPositions(unsigned int word) const
+{
+  const unsigned used = size - word * VALUES_PER_WORD;
+  if( used >= VALUES_PER_WORD )
+  {
+    return LOW_BITS;
+  }
+  return LOW_BITS & ((Word(1) << (used * Bits)) - 1);
+}
+
+template<unsigned Bits>
+unsigned sure::data::PackedMap2d<Bits>::count(unsigned value) const
+{
+  unsigned positions = 0;
+  for(unsigned int i=0; i<numberOfWords; ++i)
+  {
+    positions += countBits(matches(words[i], value) & usedPositions(i));
+  }
+  return positions;
+}
+
+template<unsigned Bits>
+unsigned sure::data::PackedMap2d<Bits>::find(unsigned value, unsigned from, unsigned to) const
+{
+  if( to > size )
+  {
+    to = size;
+  }
+  if( from >= to )
+  {
+    return to;
+  }
+  unsigned int word = from / VALUES_PER_WORD;
+  Word found = matches(words[word], value) & usedPositions(word) & (~Word(0) << ((from % VALUES_PER_WORD) * Bits));
+  while( !found )
+  {
+    word++;
+    if( word * VALUES_PER_WORD >= to )
+    {
+      return to;
+    }
+    found = matches(words[word], value) & usedPositions(word);
+  }
+  const unsigned index = word * VALUES_PER_WORD + lowestBit(found) / Bits;
+  return index < to ? index : to;
+}
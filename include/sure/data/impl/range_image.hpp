@@ -172,28 +172,119 @@ typename sure::range_image::RangeImage<PointT>::Border sure::range_image::RangeI
  * Adds points on foreground depth borders along the view direction
  * @param stepDist distance between two added points
  * @param maxPointDist maximum allowed distance from originating point
- * @param addedPoints contains the added points
+ * @param addedPoints contains the added points, its memory is reused
+ * @param maxPoints maximum number of added points, zero disables the limit
  */
 template <typename PointT>
-void sure::range_image::RangeImage<PointT>::addPointsOnBorders(Scalar stepDist, Scalar maxPointDist, pcl::PointCloud<PointT>& addedPoints)
+void sure::range_image::RangeImage<PointT>::addPointsOnBorders(Scalar stepDist, Scalar maxPointDist, pcl::PointCloud<PointT>& addedPoints, std::size_t maxPoints)
 {
   Vector3 viewPoint(input_->sensor_origin_[0], input_->sensor_origin_[1], input_->sensor_origin_[2]);
   addedPoints.clear();
   addedPoints.header = input_->header;
 
-  for(unsigned int i=0; i<this->size; ++i)
+  const int w = this->width, h = this->height, size = this->size;
+  const int threads = sure::getNumberOfThreads(threads_);
+  if( borderDistances_.size() != this->size || borderMap.size != this->size )
   {
-    Scalar maxDist;
-    if( calculateBorder(i, maxDist) == sure::range_image::RangeImage<PointT>::FOREGROUND )
+    calculateBorderMap();
+    if( borderDistances_.size() != this->size || borderMap.size != this->size )
     {
-      maxDist = std::min(maxDist, maxPointDist);
+      return;
+    }
+  }
+  rayPoints_.assign(size, 0);
+
+  // counts the points along every foreground border ray with the same accumulation as below
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+  for(int y=0; y<h; ++y)
+  {
+    const unsigned end = (y+1)*w;
+    for(unsigned i=borderMap.find(FOREGROUND, y*w, end); i<end; i=borderMap.find(FOREGROUND, i+1, end))
+    {
+      const Scalar maxDist = std::min((Scalar) borderDistances_[i], maxPointDist);
+      int points = 0;
+      for(float distanceDone = 0.f; distanceDone < maxDist; distanceDone += stepDist)
+      {
+        points++;
+      }
+      rayPoints_[i] = points;
+    }
+  }
+
+  std::vector<std::size_t> raysPerLength;
+  std::size_t total = 0;
+  for(int i=0; i<size; ++i)
+  {
+    const unsigned points = rayPoints_[i];
+    if( points >= raysPerLength.size() )
+    {
+      raysPerLength.resize(points+1, 0);
+    }
+    raysPerLength[points]++;
+    total += points;
+  }
+
+  // With a limit, every ray keeps its points closest to the border up to a common length. The remaining points are
+  // spread evenly over the longer rays.
+  int length = std::numeric_limits<int>::max();
+  std::size_t remaining = 0, longerRays = 0;
+  if( maxPoints > 0 && total > maxPoints )
+  {
+    std::size_t used = 0;
+    longerRays = size - raysPerLength[0];
+    length = 0;
+    while( used + longerRays <= maxPoints )
+    {
+      used += longerRays;
+      length++;
+      longerRays -= raysPerLength[length];
+    }
+    remaining = maxPoints - used;
+  }
 
+  rowOffsets_.resize(h);
+  std::size_t offset = 0, longerRay = 0;
+  for(int i=0; i<size; ++i)
+  {
+    if( i % w == 0 )
+    {
+      rowOffsets_[i / w] = offset;
+    }
+    if( rayPoints_[i] > length )
+    {
+      rayPoints_[i] = length;
+      if( (longerRay+1) * remaining / longerRays > longerRay * remaining / longerRays )
+      {
+        rayPoints_[i]++;
+      }
+      longerRay++;
+    }
+    offset += rayPoints_[i];
+  }
+  if( offset == 0 )
+  {
+    return;
+  }
+  addedPoints.points.resize(offset);
+  addedPoints.width = offset;
+  addedPoints.height = 1;
+
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+  for(int y=0; y<h; ++y)
+  {
+    std::size_t index = rowOffsets_[y];
+    for(int i=y*w; i<(y+1)*w; ++i)
+    {
+      if( rayPoints_[i] == 0 )
+      {
+        continue;
+      }
       Vector3 startPoint(input_->points[i].x, input_->points[i].y, input_->points[i].z);
       Vector3 viewDirection(startPoint - viewPoint);
       float startPointColor = input_->points[i].rgb;
       float distanceDone = 0.f;
 
-      while( distanceDone < maxDist )
+      for(int j=0; j<rayPoints_[i]; ++j)
       {
         PointT p;
         distanceDone += stepDist;
@@ -202,17 +293,40 @@ void sure::range_image::RangeImage<PointT>::addPointsOnBorders(Scalar stepDist,
         p.y = newPoint[1];
         p.z = newPoint[2];
         p.rgb = startPointColor;
-        addedPoints.push_back(p);
+        addedPoints.points[index++] = p;
       }
     }
   }
 }
 
 template <typename PointT>
-void sure::range_image::RangeImage<PointT>::calculateBorderMap()
+inline typename sure::range_image::RangeImage<PointT>::Border sure::range_image::RangeImage<PointT>::classifyBorder(bool valid, float referenceDistance, float minNeighbor, float maxNeighbor, float& dist)
 {
-  Scalar dummy;
+  if( !valid || isinf(referenceDistance) || referenceDistance == MAX_USED_POINT_DISTANCE || isinf(maxNeighbor) )
+  {
+    dist = MAX_USED_POINT_DISTANCE;
+    return BACKGROUND;
+  }
+  const float minDist = std::min((float) MAX_USED_POINT_DISTANCE, minNeighbor);
+  const float maxDist = std::max(0.f, maxNeighbor);
+  Border border = NONE;
+  dist = 0.f;
+  if( maxDist > referenceDistance*DEPTH_JUMP_FACTOR )
+  {
+    border = FOREGROUND;
+    dist = maxDist - referenceDistance;
+  }
+  if( minDist < referenceDistance/DEPTH_JUMP_FACTOR )
+  {
+    border = BACKGROUND;
+    dist = referenceDistance - minDist;
+  }
+  return border;
+}
 
+template <typename PointT>
+void sure::range_image::RangeImage<PointT>::calculateBorderMap()
+{
   if( borderMap.width != input_->width || borderMap.height != input_->height )
   {
     borderMap.resize(input_->width, input_->height);
@@ -222,16 +336,92 @@ void sure::range_image::RangeImage<PointT>::calculateBorderMap()
     borderMap.clear();
   }
 
-  for(unsigned int i=0; i<indices_->size(); ++i)
+  const int w = this->width, h = this->height, size = this->size;
+  const int threads = sure::getNumberOfThreads(threads_);
+  neighborMin_.resize(this->size);
+  neighborMax_.resize(this->size);
+  borderDistances_.resize(this->size);
+  if( this->size == 0 || borderMap.size != this->size )
+  {
+    return;
+  }
+
+  // Every sweep carries the nearest finite depth along its direction, infinity if there is none. calculateBorder searches
+  // the columns 1 to width-2 and the rows 1 to height-2 only. A missing neighbor turns the maximum infinite.
+  const Scalar* depths = this->map;
+  float* minNeighbors = &neighborMin_[0];
+  float* maxNeighbors = &neighborMax_[0];
+
+  // left and right
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+  for(int y=0; y<h; ++y)
+  {
+    const Scalar* row = depths + y*w;
+    float* rowMin = minNeighbors + y*w;
+    float* rowMax = maxNeighbors + y*w;
+    float nearest = INFINITY;
+    for(int x=0; x<w; ++x)
+    {
+      rowMin[x] = rowMax[x] = nearest;
+      const float depth = row[x];
+      nearest = (x < 1 || isinf(depth)) ? nearest : depth;
+    }
+    nearest = INFINITY;
+    for(int x=w-1; x>=0; --x)
+    {
+      rowMin[x] = std::min(rowMin[x], nearest);
+      rowMax[x] = std::max(rowMax[x], nearest);
+      const float depth = row[x];
+      nearest = (x > w-2 || isinf(depth)) ? nearest : depth;
+    }
+  }
+
+  // above and below for blocks of columns
+  const int blocks = (w + SWEEP_BLOCK_SIZE - 1) / SWEEP_BLOCK_SIZE;
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+  for(int block=0; block<blocks; ++block)
   {
-      borderMap.set(i, calculateBorder(i, dummy));
-//    if( !isinf(this->at(i)) && this->at(i) < sure::MAX_USED_POINT_DISTANCE )
-//    {
-//    }
-//    else
-//    {
-//      borderMap.set(i, sure::range_image::RangeImage<PointT>::NONE);
-//    }
+    const int begin = block * SWEEP_BLOCK_SIZE, end = std::min(begin + SWEEP_BLOCK_SIZE, w);
+    float nearest[SWEEP_BLOCK_SIZE];
+    std::fill(nearest, nearest + SWEEP_BLOCK_SIZE, (float) INFINITY);
+    for(int y=0; y<h; ++y)
+    {
+      for(int x=begin, index=y*w+begin; x<end; ++x, ++index)
+      {
+        minNeighbors[index] = std::min(minNeighbors[index], nearest[x-begin]);
+        maxNeighbors[index] = std::max(maxNeighbors[index], nearest[x-begin]);
+        const float depth = depths[index];
+        nearest[x-begin] = (y < 1 || isinf(depth)) ? nearest[x-begin] : depth;
+      }
+    }
+    std::fill(nearest, nearest + SWEEP_BLOCK_SIZE, (float) INFINITY);
+    for(int y=h-1; y>=0; --y)
+    {
+      for(int x=begin, index=y*w+begin; x<end; ++x, ++index)
+      {
+        minNeighbors[index] = std::min(minNeighbors[index], nearest[x-begin]);
+        maxNeighbors[index] = std::max(maxNeighbors[index], nearest[x-begin]);
+        const float depth = depths[index];
+        nearest[x-begin] = (y > h-2 || isinf(depth)) ? nearest[x-begin] : depth;
+      }
+    }
+  }
+
+  // classification, every thread assembles whole words of the border map
+  typedef sure::data::PackedMap2d<2> BorderMap;
+  float* distances = &borderDistances_[0];
+  const int words = borderMap.numberOfWords;
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+  for(int word=0; word<words; ++word)
+  {
+    const int begin = word * BorderMap::VALUES_PER_WORD, end = std::min(begin + (int) BorderMap::VALUES_PER_WORD, size);
+    BorderMap::Word borders = 0;
+    for(int index=begin; index<end; ++index)
+    {
+      const Border border = classifyBorder(this->valid.at(index), depths[index], minNeighbors[index], maxNeighbors[index], distances[index]);
+      borders |= BorderMap::Word(border) << ((index-begin) * BorderMap::BITS);
+    }
+    borderMap.words[word] = borders;
   }
 }
 
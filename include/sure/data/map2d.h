@@ -36,8 +36,11 @@
 
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <algorithm>
 #include <vector>
 
+#include <sure/data/packed_map2d.h>
+
 namespace sure
 {
   namespace data
@@ -45,12 +48,16 @@ namespace sure
 
     /**
      * 2D data structure with information wether a position contains information or not
+     * The validity is stored as a bit mask
      */
     template<typename Type>
     class Map2d
     {
       public:
 
+        typedef PackedMap2d<1> ValidityMap;
+        typedef typename ValidityMap::Reference ValidityReference;
+
         Map2d();
         Map2d(Type defaultValue);
         Map2d(unsigned int width, unsigned int height);
@@ -73,9 +80,15 @@ namespace sure
         Type& at(unsigned int x, unsigned int y) { return at(y*width+x); }
 
         bool exists(unsigned int index) const;
-        bool& exists(unsigned int index);
+        ValidityReference exists(unsigned int index);
         bool exists(unsigned int x, unsigned int y) const { return exists(y*width+x); }
-        bool& exists(unsigned int x, unsigned int y) { return exists(y*width+x); }
+        ValidityReference exists(unsigned int x, unsigned int y) { return exists(y*width+x); }
+
+        //! Number of valid positions
+        unsigned int countValid() const { return valid.count(true); }
+
+        //! First valid position starting at index, size if there is none
+        unsigned int nextValid(unsigned int index) const { return valid.find(true, index); }
 
         void set(unsigned int index, const Type& t);
         void set(unsigned int x, unsigned int y, const Type& t) { set(y*width+x, t); }
@@ -90,10 +103,10 @@ namespace sure
         Map2d<Type> subsample(int step) const;
 
         Type* map;
-        bool* valid;
+        ValidityMap valid;
 
         Type defaultValue, invalidValue;
-        bool invalidStatus;
+        typename ValidityMap::Word invalidStatus;
 
         unsigned int width, height, size;
 
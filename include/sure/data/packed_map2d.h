@@ -0,0 +1,135 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_PACKED_MAP2D_H_
+#define SURE_PACKED_MAP2D_H_
+
+#include <stdint.h>
+
+namespace sure
+{
+  namespace data
+  {
+
+    /**
+     * 2D map of small codes with Bits bits per position, packed into 64 bit words. Bits has to divide 64.
+     * Clearing sets all words to zero, count and find test a whole word at once.
+     */
+    template<unsigned Bits>
+    class PackedMap2d
+    {
+      public:
+
+        typedef uint64_t Word;
+
+        static const unsigned BITS = Bits;
+        static const unsigned BITS_PER_WORD = 64;
+        static const unsigned VALUES_PER_WORD = BITS_PER_WORD / Bits;
+        static const Word VALUE_MASK = (Word(1) << Bits) - 1;
+
+        //! Lowest bit of every position in a word
+        static const Word LOW_BITS = ~Word(0) / VALUE_MASK;
+
+        /**
+         * Reference to a single position, so codes can be assigned like with a plain array
+         */
+        class Reference
+        {
+          public:
+
+            Reference(Word& word, unsigned shift) : word_(word), shift_(shift) { }
+
+            operator unsigned() const { return (word_ >> shift_) & VALUE_MASK; }
+
+            Reference& operator=(unsigned value)
+            {
+              word_ = (word_ & ~(VALUE_MASK << shift_)) | ((Word(value) & VALUE_MASK) << shift_);
+              return *this;
+            }
+            Reference& operator=(const Reference& rhs) { return operator=((unsigned) rhs); }
+
+          private:
+
+            Word& word_;
+            unsigned shift_;
+
+        };
+
+        PackedMap2d();
+        PackedMap2d(unsigned int width, unsigned int height);
+        PackedMap2d(const PackedMap2d<Bits>& obj);
+        ~PackedMap2d() { reset(); }
+
+        void reset();
+        void clear();
+        void resize(unsigned int width, unsigned int height);
+
+        PackedMap2d<Bits>& operator=(const PackedMap2d<Bits>& rValue);
+
+        unsigned at(unsigned int index) const;
+        unsigned at(unsigned int x, unsigned int y) const { return at(y*width+x); }
+        Reference at(unsigned int index) { return Reference(words[index / VALUES_PER_WORD], (index % VALUES_PER_WORD) * Bits); }
+        Reference at(unsigned int x, unsigned int y) { return at(y*width+x); }
+
+        void set(unsigned int index, unsigned value);
+        void set(unsigned int x, unsigned int y, unsigned value) { set(y*width+x, value); }
+
+        //! Number of positions holding value
+        unsigned count(unsigned value) const;
+
+        //! First position in [from, to) holding value, to if there is none
+        unsigned find(unsigned value, unsigned from, unsigned to) const;
+        unsigned find(unsigned value, unsigned from = 0) const { return find(value, from, size); }
+
+        //! Sets the lowest bit of every position in word which holds value
+        static Word matches(Word word, unsigned value);
+
+        Word* words;
+        unsigned int numberOfWords;
+
+        unsigned int width, height, size;
+
+      protected:
+
+        //! Lowest bits of the positions of a word which lie inside the map
+        Word usedPositions(unsigned int word) const;
+
+    };
+
+  } // namespace
+} // namespace
+
+#include "sure/data/impl/packed_map2d.hpp"
+
+#endif /* SURE_PACKED_MAP2D_H_ */
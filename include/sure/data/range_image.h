@@ -34,12 +34,15 @@
 #ifndef SURE_RANGE_IMAGE_H_
 #define SURE_RANGE_IMAGE_H_
 
+#include <vector>
+
 #include <pcl/point_types.h>
 #include <pcl/io/pcd_io.h>
 #include <pcl/range_image/range_image.h>
 
 #include <sure/data/typedef.h>
 #include <sure/data/map2d.h>
+#include <sure/data/packed_map2d.h>
 
 namespace sure
 {
@@ -69,8 +72,11 @@ namespace sure
 
       static const float DEPTH_JUMP_FACTOR = 1.1f;
 
-      RangeImage() : Map2d(std::numeric_limits<Scalar>::infinity()), borderMap(NONE) { }
-      RangeImage(const RangeImage<PointT>& rhs) : Map2d(rhs), pcl::PCLBase<PointT>(rhs), borderMap(rhs.borderMap) { }
+      //! Number of columns handled together by the vertical sweeps of calculateBorderMap
+      static const int SWEEP_BLOCK_SIZE = 64;
+
+      RangeImage() : Map2d(std::numeric_limits<Scalar>::infinity()), borderMap(), threads_(0) { }
+      RangeImage(const RangeImage<PointT>& rhs) : Map2d(rhs), pcl::PCLBase<PointT>(rhs), borderMap(rhs.borderMap), borderDistances_(rhs.borderDistances_), threads_(rhs.threads_) { }
       ~RangeImage() { }
 
       void reset()
@@ -80,13 +86,23 @@ namespace sure
 
       void calculateRangeImage();
 
-      bool isBackgroundBorder(int index) const { return (borderMap.at(index) == BACKGROUND); }
-      bool isForegroundBorder(int index) const { return (borderMap.at(index) == FOREGROUND); }
+      bool isBackgroundBorder(int index) const { return ((Border) borderMap.at(index) == BACKGROUND); }
+      bool isForegroundBorder(int index) const { return ((Border) borderMap.at(index) == FOREGROUND); }
+
+      /**
+       * Adds points along the view direction behind foreground depth borders. Counts the points first and writes them
+       * into addedPoints in pixel order, so its memory is reused between frames.
+       */
+      void addPointsOnBorders(Scalar stepDist, Scalar maxPointDist, pcl::PointCloud<PointT>& addedPoints, std::size_t maxPoints = 0);
 
-      void addPointsOnBorders(Scalar stepDist, Scalar maxPointDist, pcl::PointCloud<PointT>& addedPoints);
+      Border hasBorder(int index) const { return (Border) borderMap.at(index); }
+      Border hasBorder(int x, int y) const { return (Border) borderMap.at(x, y); }
 
-      Border hasBorder(int index) const { return borderMap.at(index); }
-      Border hasBorder(int x, int y) const { return borderMap.at(x, y); }
+      /**
+       * Number of threads for the border detection. Zero or less selects all available threads.
+       */
+      void setNumberOfThreads(int threads) { threads_ = threads; }
+      int getNumberOfThreads() const { return threads_; }
 
       protected:
 
@@ -94,10 +110,38 @@ namespace sure
       float getDensity(int x, int y, int radius = 1);
       float getMeanDensity(int x, int y, int radius = 1);
 
+      /**
+       * Classifies all pixels like calculateBorder in linear time: Four sweeps along the rows and columns find the nearest
+       * finite depth in every direction, followed by one pass for the classification. Caches the depth jump of every pixel.
+       */
       void calculateBorderMap();
+
+      /**
+       * Classifies a single pixel by searching the nearest finite depth in all four directions, which takes up to
+       * width + height steps. dist receives the depth jump to the neighbor, or MAX_USED_POINT_DISTANCE if one is missing.
+       */
       Border calculateBorder(int index, Scalar& dist) const;
 
-      sure::data::Map2d<Border> borderMap;
+      /**
+       * Classification of calculateBorder for the minimum and maximum of the nearest finite depths in all four directions.
+       * An infinite maximum denotes a missing neighbor.
+       */
+      static Border classifyBorder(bool valid, float referenceDistance, float minNeighbor, float maxNeighbor, float& dist);
+
+      //! Border of every pixel with two bits per pixel
+      sure::data::PackedMap2d<2> borderMap;
+
+      //! Depth jump of every pixel as returned by calculateBorder, filled by calculateBorderMap
+      std::vector<float> borderDistances_;
+
+      //! Minimum and maximum of the nearest finite depths in all directions, infinite maximum if one direction has none
+      std::vector<float> neighborMin_, neighborMax_;
+
+      //! Number of added points of every pixel and the offset of every row in the added points
+      std::vector<int> rayPoints_;
+      std::vector<std::size_t> rowOffsets_;
+
+      int threads_;
 
     };
 
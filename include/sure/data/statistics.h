@@ -0,0 +1,187 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_STATISTICS_H_
+#define SURE_STATISTICS_H_
+
+#include <ctime>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <ostream>
+
+#include <pcl/common/time.h>
+
+#include <sure/data/typedef.h>
+
+namespace sure
+{
+
+  //! Number of values of sure::MaximumFlag
+  const int NUMBER_OF_MAXIMUM_FLAGS = ARTIFICIAL_POINTS + 1;
+
+  //! Returns a readable name of a maximum flag
+  const char* getMaximumFlagName(MaximumFlag flag);
+
+  /**
+   * Wall and cpu time in milliseconds. The cpu time is taken for the whole process, so it covers all worker threads.
+   */
+  struct Timing
+  {
+    Timing() : wall(0.0), cpu(0.0) { }
+
+    Scalar wall, cpu;
+
+    Timing& operator+=(const Timing& rhs) { wall += rhs.wall; cpu += rhs.cpu; return *this; }
+  };
+
+  /**
+   * Measures wall and cpu time since construction or the last reset
+   */
+  class StageTimer
+  {
+    public:
+
+      StageTimer() { reset(); }
+
+      void reset()
+      {
+        watch_.reset();
+        clock_ = std::clock();
+      }
+
+      Timing getTime()
+      {
+        Timing t;
+        t.wall = watch_.getTime();
+        t.cpu = (Scalar) (std::clock() - clock_) * 1000.0 / (Scalar) CLOCKS_PER_SEC;
+        return t;
+      }
+
+      //! Returns the time and resets the timer
+      Timing lap()
+      {
+        Timing t = getTime();
+        reset();
+        return t;
+      }
+
+    protected:
+
+      pcl::StopWatch watch_;
+      std::clock_t clock_;
+  };
+
+  /**
+   * Counters of the keypoint extraction on a single scale
+   */
+  struct ScaleStatistics
+  {
+    ScaleStatistics(Scalar s = 0.0) : scale(s), keypoints(0), redundantKeypoints(0)
+    {
+      std::fill(flagCounts, flagCounts + NUMBER_OF_MAXIMUM_FLAGS, 0u);
+    }
+
+    //! Scale in meters
+    Scalar scale;
+
+    //! Time for entropy, cornerness, extraction and localization
+    Timing time;
+
+    //! Keypoints found on the scale, before removing redundant ones
+    unsigned keypoints;
+
+    //! Keypoints removed after improving the localization
+    unsigned redundantKeypoints;
+
+    //! Number of nodes in the sampling depth per flag after the extraction, indexed by sure::MaximumFlag
+    unsigned flagCounts[NUMBER_OF_MAXIMUM_FLAGS];
+  };
+
+  /**
+   * Timings and counters of a feature calculation. Retained by SUREFeatureExtractor until the next calculation.
+   */
+  class Statistics
+  {
+    public:
+
+      enum Stage
+      {
+        OCTREE_STAGE = 0,
+        NORMAL_STAGE,
+        KEYPOINT_STAGE,
+        FEATURE_STAGE,
+        NUMBER_OF_STAGES
+      };
+
+      Statistics() { clear(); }
+
+      void clear();
+
+      //! Returns a readable name of a stage
+      static const char* getStageName(Stage stage);
+
+      //! Time per stage, the octree stage includes the range image
+      Timing stages[NUMBER_OF_STAGES];
+
+      //! Time of the whole calculation
+      Timing total;
+
+      //! Statistics of every scale in the order of the configuration
+      std::vector<ScaleStatistics> scales;
+
+      //! Number of octree nodes per depth
+      std::vector<unsigned> nodesPerDepth;
+
+      //! Points of the input cloud and artificial points on depth borders
+      unsigned points, artificialPoints;
+
+      unsigned normals, keypoints, descriptors;
+
+      //! Normals integrated with the integral images of an organized point cloud instead of the octree
+      unsigned imageNormals;
+
+      //! Sum of the flags of all scales, indexed by sure::MaximumFlag
+      unsigned flagCounts[NUMBER_OF_MAXIMUM_FLAGS];
+
+      //! Utilization of the octree node pool, see sure::memory::ChunkedAllocator
+      std::size_t allocatorSize, allocatorCapacity, allocatorHighWaterMark, allocatorMemory;
+
+  };
+
+  std::ostream& operator<<(std::ostream& stream, const sure::Statistics& statistics);
+
+}
+
+#endif /* SURE_STATISTICS_H_ */
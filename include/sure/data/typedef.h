@@ -54,6 +54,20 @@ namespace sure
     CROSS_PRODUCTS_PAIRWISE
   };
 
+  /**
+   * Defines how point clouds are inserted into the octree:
+   * INCREMENTAL_INSERTION: Every point descends separately from the root to its leaf
+   * MORTON_SORTED_INSERTION: Points are sorted along their morton codes in parallel and the tree is built bottom-up
+   * CONCURRENT_INSERTION: Threads descend the tree concurrently, claim new nodes with compare-and-swap and merge their
+   * point moments afterwards
+   */
+  enum OctreeConstructionMode
+  {
+    INCREMENTAL_INSERTION = 0,
+    MORTON_SORTED_INSERTION,
+    CONCURRENT_INSERTION
+  };
+
   /**
    * Flags regarding the points contained in a node
    */
@@ -121,6 +135,9 @@ namespace sure
 
   const Scalar getNormalHistogramBinSize(unsigned numberOfPolarBins);
 
+  //! Returns the number of worker threads for parallel stages. Zero or less selects all available threads
+  int getNumberOfThreads(int requested);
+
   // *********
   // Constants
   // *********
@@ -43,6 +43,9 @@ namespace sure
 
     typedef sure::descriptor::Histogram<COLOR_DESCRIPTOR_SIZE> ColorHistogram;
 
+    //! Size of the normalized color histogram with the saturation balance, as used for the earth mover's distance
+    const int COLOR_DISTANCE_VECTOR_SIZE = COLOR_DESCRIPTOR_SIZE + EXTRA_BIN_FOR_SATURATION_BALANCE;
+
     std::vector<std::vector<double> > initColorDescriptorEMDMatrix();
 
     void convertRGBtoHSL(Scalar r, Scalar g, Scalar b, Scalar& h, Scalar& s, Scalar& l);
@@ -63,6 +66,14 @@ namespace sure
         void insertValue(Scalar hue, Scalar saturation);
         Scalar distanceTo(const ColorDescriptor& rhs) const;
 
+        //! Writes the normalized histogram followed by the saturation balance to COLOR_DISTANCE_VECTOR_SIZE values
+        void getDistanceVector(double* values) const;
+
+        //! Earth mover's distance between two distance vectors of COLOR_DISTANCE_VECTOR_SIZE values, scaled to [0,1]
+        static Scalar distance(const double* lhs, const double* rhs);
+
+        static Scalar distance(const std::vector<double>& lhs, const std::vector<double>& rhs) { return distance(&lhs[0], &rhs[0]); }
+
       protected:
 
         static const std::vector<std::vector<double> > DISTANCE_MATRIX;
@@ -113,6 +113,10 @@ namespace sure
         void insertValues(HistoType alpha, HistoType phi, HistoType theta);
         Scalar distanceTo(const ShapeDescriptor& rhs) const;
 
+        const ShapeHistogram& alpha() const { return alpha_; }
+        const ShapeHistogram& phi() const { return phi_; }
+        const ShapeHistogram& theta() const { return theta_; }
+
       protected:
 
         ShapeHistogram alpha_;
@@ -37,8 +37,8 @@
 #include <Eigen/Dense>
 
 #include <sure/data/typedef.h>
-#include <sure/payload/payload_xyzrgb.h>
-#include <sure/payload/payload_normal.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
 #include <sure/octree/octree_node.h>
 #include <sure/octree/octree.h>
 #include <sure/normal/normal.h>
@@ -50,9 +50,9 @@ namespace sure
   namespace feature
   {
 
-    typedef sure::payload::PointsRGB FixedPayload;
+    typedef sure::payload::PointMoments FixedPayload;
     typedef sure::octree::Node<FixedPayload> Node;
-    typedef sure::payload::NormalPayload NormalPayload;
+    typedef sure::payload::NormalTable NormalTable;
     typedef sure::octree::Octree<FixedPayload> Octree;
     typedef Octree::NodeVector NodeVector;
     typedef sure::descriptor::Descriptor Descriptor;
@@ -113,15 +113,30 @@ namespace sure
          */
         Scalar distanceTo(const Feature& rhs, Scalar shapeWeight = 1.0, Scalar colorWeight = 1.0, Scalar lightnessWeight = 1.0) const;
 
-        int createDescriptor(const NodeVector& nodes, Scalar referenceLightness, unsigned distanceClasses);
+        /**
+         * Creates the descriptor from the given nodes. The normals have to be allocated for the depth of the nodes,
+         * without normals the shape descriptor stays empty.
+         */
+        int createDescriptor(const NodeVector& nodes, Scalar referenceLightness, unsigned distanceClasses, const NormalTable* normals = NULL);
+
+        /**
+         * Creates the descriptor incrementally: prepareDescriptor resets it, the insert methods add a single node
+         * to the shape, color and lightness descriptor and return true if the node was used, finishDescriptor normalizes it.
+         * insertShape uses the normal of the node from the given table, allocated for the depth of the node, and fails without one.
+         */
+        void prepareDescriptor(Scalar referenceLightness, unsigned distanceClasses);
+        bool insertShape(const Node* node, const NormalTable* normals);
+        bool insertColor(const Node* node);
+        bool insertLightness(const Node* node);
+        void finishDescriptor();
 
       protected:
 
         void resetDescriptor(unsigned distanceClasses = sure::feature::DEFAULT_NUMBER_OF_DESCRIPTORS);
 
-        int createShapedescriptor(const NodeVector& nodes);
+        int createShapedescriptor(const NodeVector& nodes, const NormalTable* normals);
         int createColordescriptor(const NodeVector& nodes);
-        int createLightnessdescriptor(const NodeVector& nodes, Scalar referenceLightness);
+        int createLightnessdescriptor(const NodeVector& nodes);
         unsigned getDistanceClass(const Vector3& center, const Vector3& pos) const;
 
         Vector3 position_;
@@ -139,6 +154,26 @@ namespace sure
 
     std::ostream& operator<<(std::ostream& stream, const Feature& rhs);
 
+    /**
+     * Visitor for Octree::forEachNodeIn, which inserts all visited nodes in the descriptor of a prepared feature.
+     * The normals have to be allocated for the visited depth or NULL.
+     */
+    struct DescriptorInserter
+    {
+        DescriptorInserter(Feature& feature, const NormalTable* normals) : feature_(feature), normals_(normals), shapePoints_(0), colorPoints_(0), lightnessPoints_(0) { }
+        bool operator()(Node* node)
+        {
+          shapePoints_ += feature_.insertShape(node, normals_);
+          colorPoints_ += feature_.insertColor(node);
+          lightnessPoints_ += feature_.insertLightness(node);
+          return true;
+        }
+        int usedPoints() const { return std::min(shapePoints_, std::min(colorPoints_, lightnessPoints_)); }
+        Feature& feature_;
+        const NormalTable* normals_;
+        int shapePoints_, colorPoints_, lightnessPoints_;
+    };
+
   } // namespace
 } //namespace
 
@@ -34,8 +34,8 @@
 #ifndef SURE_FEATURE_EXTRACTION_H_
 #define SURE_FEATURE_EXTRACTION_H_
 
-#include <sure/payload/payload_xyzrgb.h>
-#include <sure/payload/payload_normal.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
 #include <sure/octree/octree_node.h>
 #include <sure/octree/octree.h>
 #include <sure/normal/normal_estimation.h>
@@ -48,9 +48,9 @@ namespace sure
   namespace feature
   {
 
-    typedef sure::payload::PointsRGB FixedPayload;
+    typedef sure::payload::PointMoments FixedPayload;
     typedef sure::octree::Node<FixedPayload> Node;
-    typedef sure::payload::NormalPayload NormalPayload;
+    typedef sure::payload::NormalTable NormalTable;
     typedef sure::octree::Octree<FixedPayload> Octree;
     typedef Octree::NodeVector NodeVector;
     typedef sure::descriptor::ShapeDescriptor ShapeDescriptor;
@@ -60,6 +60,7 @@ namespace sure
     /**
      * Creates a feature on a given position and a given feature normal
      * @param octree
+     * @param normals Normals for the shape descriptor, only used if allocated for the samplingrate
      * @param position The position for the feature
      * @param samplingrate Samplingrate of the octree nodes used for the descriptor calculation, usually the normal samplingrate
      * @param radius Corresponds to the scale of the feature
@@ -67,11 +68,12 @@ namespace sure
      * @param distanceClasses Number of distance classes for the descriptor
      * @return
      */
-    Feature createFeature(const Octree& octree, const Vector3& position, Scalar samplingrate, Scalar radius, const sure::normal::Normal& normal, unsigned distanceClasses);
+    Feature createFeature(const Octree& octree, const NormalTable& normals, const Vector3& position, Scalar samplingrate, Scalar radius, const sure::normal::Normal& normal, unsigned distanceClasses);
 
     /**
      * Creates a feature on a given position
      * @param octree
+     * @param normals Normals for the shape descriptor, only used if allocated for the samplingrate
      * @param position The position for the feature
      * @param samplingrate Samplingrate of the octree nodes used for the descriptor calculation, usually the normal samplingrate
      * @param radius Corresponds to the scale of the feature
@@ -79,27 +81,30 @@ namespace sure
      * @param distanceClasses Number of distance classes for the descriptor
      * @return
      */
-    Feature createFeature(const Octree& octree, const Vector3& position, Scalar samplingrate, Scalar radius, const Vector3& viewPoint, unsigned distanceClasses);
+    Feature createFeature(const Octree& octree, const NormalTable& normals, const Vector3& position, Scalar samplingrate, Scalar radius, const Vector3& viewPoint, unsigned distanceClasses);
 
     /**
      * Creates the descriptors for a given set of features
      * @param octree
+     * @param normals Normals for the shape descriptor, only used if allocated for the samplingrate
      * @param features
      * @param samplingrate Samplingrate of the octree nodes used for the descriptor calculation, usually the normal samplingrate
      * @param viewPoint The point towards the features' normal will be orientated to.
      * @param distanceClasses Number of distance classes for the descriptor
+     * @param threads Number of worker threads, zero selects all available threads. The descriptors do not depend on it
      */
-    unsigned createDescriptors(const Octree& octree, std::vector<Feature>& features, Scalar samplingrate, const Vector3& viewPoint, unsigned distanceClasses);
+    unsigned createDescriptors(const Octree& octree, const NormalTable& normals, std::vector<Feature>& features, Scalar samplingrate, const Vector3& viewPoint, unsigned distanceClasses, int threads = 0);
 
     /**
      * Creates a descriptor for a given feature. The feature must already contain a normal
      * @param octree
+     * @param normals Normals for the shape descriptor, only used if allocated for the samplingrate
      * @param feature
      * @param samplingrate Samplingrate of the octree nodes used for the descriptor calculation, usually the normal samplingrate
      * @param distanceClasses Number of distance classes for the descriptor
      * @return
      */
-    bool createDescriptor(const Octree& octree, Feature& feature, Scalar samplingrate, unsigned distanceClasses);
+    bool createDescriptor(const Octree& octree, const NormalTable& normals, Feature& feature, Scalar samplingrate, unsigned distanceClasses);
 
   } // namespace
 } // namespace
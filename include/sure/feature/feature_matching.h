@@ -0,0 +1,128 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_FEATURE_MATCHING_H_
+#define SURE_FEATURE_MATCHING_H_
+
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include <sure/data/typedef.h>
+#include <sure/descriptor/descriptor.h>
+#include <sure/feature/feature.h>
+
+namespace sure
+{
+  namespace feature
+  {
+
+    /**
+     * The descriptors of a list of features, packed for calculating many distances at once.
+     * The shape and lightness histograms of LANES features are interleaved bin by bin, so a single instruction
+     * handles the same bin of LANES features. The color histograms are stored as normalized distance vectors.
+     */
+    class PackedDescriptors
+    {
+      public:
+
+        //! Number of interleaved features, the number of floats in an AVX register
+        static const unsigned LANES = 8;
+
+        //! Number of interleaved bins: alpha, phi and theta of the shape descriptor followed by the lightness descriptor
+        static const unsigned BINS = 3 * sure::descriptor::SHAPE_DESCRIPTOR_SIZE + sure::descriptor::LIGHTNESS_DESCRIPTOR_SIZE;
+
+        //! Floats per block of LANES features and a single distance class: all bins followed by the four histogram weights
+        static const unsigned BLOCK_SIZE = (BINS + 4) * LANES;
+
+        PackedDescriptors() : size_(0), classes_(0) { }
+
+        PackedDescriptors(const std::vector<Feature>& features) : size_(0), classes_(0) { pack(features); }
+
+        //! Packs the descriptors of all features. The buffers only grow between calls
+        void pack(const std::vector<Feature>& features);
+
+        //! Number of packed features
+        unsigned size() const { return size_; }
+
+        //! Maximum number of distance classes of the packed features
+        unsigned numberOfClasses() const { return classes_; }
+
+        //! Number of distance classes of a single feature
+        unsigned numberOfDescriptors(unsigned feature) const { return descriptors_[feature]; }
+
+        Scalar radius(unsigned feature) const { return radii_[feature]; }
+
+        //! Returns the interleaved histograms of the block containing the feature
+        const float* block(unsigned feature, unsigned distanceClass) const
+        {
+          return &histograms_[((feature / LANES) * classes_ + distanceClass) * BLOCK_SIZE];
+        }
+
+        //! Returns the COLOR_DISTANCE_VECTOR_SIZE values of the color descriptor
+        const double* color(unsigned feature, unsigned distanceClass) const
+        {
+          return &colors_[(feature * classes_ + distanceClass) * sure::descriptor::COLOR_DISTANCE_VECTOR_SIZE];
+        }
+
+      protected:
+
+        unsigned size_, classes_;
+        std::vector<float, Eigen::aligned_allocator<float> > histograms_;
+        std::vector<double> colors_;
+        std::vector<unsigned> descriptors_;
+        std::vector<Scalar> radii_;
+
+    };
+
+    /**
+     * Calculates the distances between all pairs of two lists of features. Each entry equals Feature::distanceTo
+     * with the same weights, the shape and lightness histograms are compared with SIMD instructions for LANES columns at once.
+     * The earth mover's distance of the color descriptors is skipped for a color weight of zero.
+     * @param rows Descriptors of the first features
+     * @param columns Descriptors of the second features
+     * @param distances Receives the distances in row major order, distances[i * columns.size() + j] compares rows i and columns j
+     * @param threads Number of worker threads, zero or less uses all available threads. Results do not depend on it
+     */
+    void calculateDistanceMatrix(const PackedDescriptors& rows, const PackedDescriptors& columns, std::vector<Scalar>& distances,
+        Scalar shapeWeight = 1.0, Scalar colorWeight = 1.0, Scalar lightnessWeight = 1.0, int threads = 0);
+
+    //! Same as above, packs the descriptors of the features first
+    void calculateDistanceMatrix(const std::vector<Feature>& rows, const std::vector<Feature>& columns, std::vector<Scalar>& distances,
+        Scalar shapeWeight = 1.0, Scalar colorWeight = 1.0, Scalar lightnessWeight = 1.0, int threads = 0);
+
+  } // namespace
+} // namespace
+
+#endif /* SURE_FEATURE_MATCHING_H_ */
@@ -37,16 +37,16 @@
 #include <pcl/common/eigen.h>
 
 #include <sure/data/typedef.h>
-#include <sure/memory/fixed_size_allocator_direct_access.h>
 #include <sure/feature/feature.h>
 #include <sure/normal/normal.h>
 #include <sure/normal/normal_histogram.h>
-#include <sure/payload/payload_xyzrgb.h>
-#include <sure/payload/payload_entropy.h>
-#include <sure/payload/payload_normal.h>
-#include <sure/payload/payload_cross_product.h>
+#include <sure/normal/cross_product_histogram.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
 #include <sure/octree/octree_node.h>
 #include <sure/octree/octree.h>
+#include <sure/keypoints/scale_space.h>
+#include <sure/keypoints/neighborhood_cache.h>
 
 
 namespace sure
@@ -54,156 +54,379 @@ namespace sure
   namespace keypoints
   {
     typedef sure::normal::Normal Normal;
-    typedef sure::payload::PointsRGB FixedPayload;
+    typedef sure::payload::PointMoments FixedPayload;
     typedef sure::octree::Node<FixedPayload> Node;
     typedef std::vector<Node* > NodeVector;
     typedef sure::octree::Octree<FixedPayload> Octree;
-    typedef sure::payload::NormalPayload NormalPayload;
-    typedef sure::payload::NormalPayload CrossProductPayload;
-    typedef sure::payload::EntropyPayload EntropyPayload;
+    typedef sure::payload::NormalTable NormalTable;
+    typedef sure::payload::EntropyTable EntropyTable;
     typedef sure::feature::Feature Feature;
 
     static const unsigned NUMBER_OF_MEAN_SHIFT_ITERATIONS = 3;
 
     /**
-     * Allocates the optional payload for storing entropy information on all nodes with a given edge length
+     * Resets the side table for storing entropy information on all nodes with a given edge length
      * @param octree
      * @param samplingrate Defines the edge length of the octree nodes
-     * @param allocator The allocator which allocates and owns the entropy payload
+     * @param entropy The table which stores the entropy information of the nodes
      */
-    void allocateEntropyPayload(Octree& octree, Scalar samplingrate, sure::memory::FixedSizeAllocatorWithDirectAccess<EntropyPayload>& allocator);
+    void allocateEntropyPayload(Octree& octree, Scalar samplingrate, EntropyTable& entropy);
 
     /**
      * Marks nodes containing ONLY artificial points so no feature will be extracted
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate
      */
-    void flagArtificialPoints(Octree& octree, Scalar samplingrate);
+    void flagArtificialPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate);
 
     /**
      * Marks nodes wich exceed the distance threshold to the sensor
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate
      * @param threshold Distance threshold
      * @param sensorPosition Position for defining the distance
      */
-    void flagDistantPoints(Octree& octree, Scalar samplingrate, Scalar threshold, const Vector3& sensorPosition);
+    void flagDistantPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate, Scalar threshold, const Vector3& sensorPosition);
 
     /**
      * Marks nodes containing background border points
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate
      */
-    void flagBackgroundPoints(Octree& octree, Scalar samplingrate);
+    void flagBackgroundPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate);
 
     /**
      * Resets the node flags for entropy calculation to NOT_CALCULATED, except for flags concerning
      * point structure, e.g. background and artificial flags
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate
      */
-    void resetFeatureFlags(Octree& octree, Scalar samplingrate);
+    void resetFeatureFlags(Octree& octree, EntropyTable& entropy, Scalar samplingrate);
 
     /**
      * Calculates the entropy on octree nodes corresponding to the sampling rate
      * @param octree
+     * @param normals Allocated for the normal samplingrate
+     * @param entropy Receives the entropy, allocated for the samplingrate
      * @param samplingrate Defines the octree nodes on which entropy will be calculated
      * @param normalSamplingrate Defines the octree nodes which contain normals
      * @param radius The radius in which normals will be accumulated for entropy calculation, corresponds to the scale
      * @param threshold Minimum entropy for further feature calculation steps
      * @param mode Defines wether normals or cross-products will be used
      * @param weightMethod Weight method for cross-products only
+     * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
+     * @param approximateEntropy Evaluates the entropy with a vectorized approximation of the logarithm
      */
-    void calculateEntropy(Octree& octree, Scalar samplingrate, Scalar normalSamplingrate, Scalar radius, Scalar threshold, EntropyCalculationMode mode, Scalar influenceRadius);
+    void calculateEntropy(Octree& octree, const NormalTable& normals, EntropyTable& entropy, Scalar samplingrate, Scalar normalSamplingrate, Scalar radius, Scalar threshold, EntropyCalculationMode mode, Scalar influenceRadius, int threads = 0, bool approximateEntropy = false);
 
     /**
      * Calculates the entropy on corresponding nodes with normals
      * @param octree
+     * @param normals
      * @param node
      * @param normalSamplingrate
      * @param radius
      * @return
      */
-    Scalar calculateEntropyWithNormals(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius);
+    Scalar calculateEntropyWithNormals(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy = false);
+
+    /**
+     * Calculates the entropy with normals on octree nodes corresponding to the sampling rate, like calculateEntropy in NORMALS mode,
+     * but integrates the normal histograms with a scale-space pyramid, which is shared by all scales
+     * @param octree
+     * @param pyramid Built from the normals of the octree
+     * @param entropy Receives the entropy, allocated for the samplingrate
+     * @param samplingrate Defines the octree nodes on which entropy will be calculated
+     * @param radius The radius in which normals will be accumulated for entropy calculation, corresponds to the scale
+     * @param threshold Minimum entropy for further feature calculation steps
+     * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
+     * @param approximateEntropy Evaluates the entropy with a vectorized approximation of the logarithm
+     */
+    void calculateEntropy(Octree& octree, const ScaleSpacePyramid& pyramid, EntropyTable& entropy, Scalar samplingrate, Scalar radius, Scalar threshold, int threads = 0, bool approximateEntropy = false);
+
+    /**
+     * Calculates the entropy on a node with normal histograms integrated by a scale-space pyramid
+     * @param pyramid
+     * @param node
+     * @param radius
+     * @return
+     */
+    Scalar calculateEntropyWithNormals(const ScaleSpacePyramid& pyramid, Node* node, Scalar radius, bool approximateEntropy = false);
 
     /**
      * Calculates the entropy on corresponding nodes with crossproducts between the main normal an neighboring normals
      * @param octree
+     * @param normals
      * @param node
      * @param normalSamplingrate
      * @param radius
      * @param weightMethod
      * @return
      */
-    Scalar calculateEntropyWithCrossproducts(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius);
+    Scalar calculateEntropyWithCrossproducts(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy = false);
 
     /**
      * Calculates the entropy on corresponding nodes with pairwise crossproducts between neighboring normals
      * @param octree
+     * @param normals
      * @param node
      * @param normalSamplingrate
      * @param radius
      * @param weightMethod
      * @return
      */
-    Scalar calculateEntropyWithCrossproductsPairwise(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius);
+    Scalar calculateEntropyWithCrossproductsPairwise(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy = false);
 
     /**
      * Calculates the cornerness for a given node
      * @param octree
+     * @param entropy Allocated for the depth of the node
      * @param node
      * @param radius The radius in which the cornerness will be calculated, usually corresponding to the scale
      * @return
      */
-    Scalar calculateCornerness(const Octree& octree, Node* node, Scalar radius);
+    Scalar calculateCornerness(const Octree& octree, const EntropyTable& entropy, Node* node, Scalar radius);
+
+    /**
+     * Calculates the cornerness for a node with its cached neighborhood
+     * @param neighborhoods
+     * @param entropy Allocated for the depth of the neighborhoods
+     * @param index Index of the node in its depth
+     * @return
+     */
+    Scalar calculateCornerness(const NeighborhoodCache& neighborhoods, const EntropyTable& entropy, unsigned index);
 
     /**
      * Calculates the cornerness on all node corresponding to the sampling rate and discarding nodes which miss
      * the minimum cornerness from further feature calculation steps
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingRate
      * @param radius The radius in which the cornerness will be calculated, usually corresponding to the scale
      * @param threshold Minimum cornerness required for further feature calculation steps
+     * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
+     * @param neighborhoods Used instead of querying the octree, if it contains the neighborhoods for the samplingrate and radius
      */
-    void calculateCornerness(Octree& octree, Scalar samplingRate, Scalar radius, Scalar threshold);
+    void calculateCornerness(Octree& octree, EntropyTable& entropy, Scalar samplingRate, Scalar radius, Scalar threshold, int threads = 0, const NeighborhoodCache* neighborhoods = NULL);
 
     /**
      * Extracts keypoints from entropy maxima on nodes corresponding to the samplingrate
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate
      * @param searchRadius Radius around each possible feature in which no other node contains a higher entropy
      * @param featureRadius Corresponds to the scale
      * @param features Vector containing the keypoints
+     * @param keypointNodes Receives the node of every keypoint
+     * @param neighborhoods Used instead of querying the octree, if it contains the neighborhoods for the samplingrate and search radius
      */
-    unsigned extractKeypoints(Octree& octree, Scalar samplingrate, Scalar searchRadius, Scalar featureRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes);
+    unsigned extractKeypoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate, Scalar searchRadius, Scalar featureRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes, const NeighborhoodCache* neighborhoods = NULL);
 
     /**
      * Shifts a given position with mean shift using the entropy for the gradient descent
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate Defines the octree nodes containing entropy information
      * @param radius The radius in which the mean shift will be performed, usually corresponds to the scale
      * @param position Position to be shifted
      */
-    void improveLocalization(const Octree& octree, Scalar samplingrate, Scalar radius, Vector3& position);
+    void improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, Vector3& position);
+
+    /**
+     * Same as above, but collects the neighborhood only once per iteration into the given buffer and reuses it for
+     * the mean, variance and shift
+     */
+    void improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, Vector3& position, NodeVector& neighborhood);
 
     /**
      * Improves the localization of the given features
      * @param octree
+     * @param entropy Allocated for the samplingrate
      * @param samplingrate Defines the octree nodes containing entropy information
      * @param radius The radius in which the mean shift will be performed, usually corresponds to the scale
      * @param features
      */
-    void improveLocalization(const Octree& octree, Scalar samplingrate, Scalar radius, std::vector<Feature>& features);
+    void improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, std::vector<Feature>& features);
 
     /**
      * Searchs for features which are too close after localization
      * Means: These feature originate from the same region, but were extracted on different positions due to
      * discretization errors
+     * The keypoints are bucketed in a hashed grid with the search radius as cell size, so the expected cost is linear.
      *
+     * @param entropy Allocated for the depth of the keypoint nodes
      * @param searchRadius
      * @param features
+     * @param keypointNodes Node of every feature, redundant keypoints are removed from both lists
+     * @return Number of removed keypoints
      */
-    int removeRedundantKeypoints(Scalar searchRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes);
+    int removeRedundantKeypoints(EntropyTable& entropy, Scalar searchRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes);
+
+    // ******************************************
+    // Visitors for Octree::forEachNodeIn queries
+    // ******************************************
+
+    //! Inserts the cross-products between a main normal and the stable normals of all visited nodes
+    struct CrossProductInserter
+    {
+        CrossProductInserter(const NormalTable& normals, const NormalType& mainNormal, sure::normal::CrossProductHistogram& histogram) : normals_(normals), mainNormal_(mainNormal), histogram_(histogram) { }
+        bool operator()(Node* node)
+        {
+          const Normal& normal = normals_.normals_[node->index()];
+          if( normal.isStable() )
+          {
+            histogram_.insertCrossProduct(mainNormal_, normal.vector());
+          }
+          return true;
+        }
+        const NormalTable& normals_;
+        const NormalType& mainNormal_;
+        sure::normal::CrossProductHistogram& histogram_;
+    };
+
+    //! Inserts the cross-products between the first stable normal and the stable normals of all following nodes
+    struct PairwiseCrossProductInserter
+    {
+        PairwiseCrossProductInserter(const NormalTable& normals, sure::normal::CrossProductHistogram& histogram) : normals_(normals), histogram_(histogram), first_(NULL) { }
+        bool operator()(Node* node)
+        {
+          const Normal& normal = normals_.normals_[node->index()];
+          if( !normal.isStable() )
+          {
+            return true;
+          }
+          if( !first_ )
+          {
+            first_ = &normal;
+          }
+          else
+          {
+            histogram_.insertCrossProduct(first_->vector(), normal.vector());
+          }
+          return true;
+        }
+        const NormalTable& normals_;
+        sure::normal::CrossProductHistogram& histogram_;
+        const Normal* first_;
+    };
+
+    //! Sums up the node positions weighted by their entropy
+    struct WeightedMeanAccumulator
+    {
+        WeightedMeanAccumulator(const EntropyTable& table) : table_(table), mean_(Vector3::Zero()), weight_(0.0) { }
+        bool operator()(Node* node)
+        {
+          const Scalar entropy = table_.entropy_[node->index()];
+          if( entropy > 0.0 )
+          {
+            mean_ += (entropy * node->fixed().getMeanPosition());
+            weight_ += entropy;
+          }
+          return true;
+        }
+        const EntropyTable& table_;
+        Vector3 mean_;
+        Scalar weight_;
+    };
+
+    //! Sums up the covariance of the node positions around a mean weighted by their entropy
+    struct WeightedCovarianceAccumulator
+    {
+        WeightedCovarianceAccumulator(const EntropyTable& table, const Vector3& mean) : table_(table), mean_(mean), covariance_(Matrix3::Zero()) { }
+        bool operator()(Node* node)
+        {
+          const Scalar entropy = table_.entropy_[node->index()];
+          if( entropy > 0.0 )
+          {
+            covariance_ += entropy * ( (mean_ - node->fixed().getMeanPosition()) * ((mean_ - node->fixed().getMeanPosition()).transpose()) );
+          }
+          return true;
+        }
+        const EntropyTable& table_;
+        const Vector3& mean_;
+        Matrix3 covariance_;
+    };
+
+    //! Suppresses a possible maximum, if a visited node is a maximum or has a higher entropy. Stops on suppression.
+    struct MaximumSuppressor
+    {
+        MaximumSuppressor(EntropyTable& table, unsigned index) : table_(table), index_(index) { }
+        bool operator()(Node* node)
+        {
+          const unsigned neighbor = node->index();
+          const MaximumFlag neighborFlag = table_.flags_[neighbor];
+          if( neighborFlag == IS_MAXIMUM || (neighborFlag == POSSIBLE && table_.entropy_[index_] < table_.entropy_[neighbor]) )
+          {
+            table_.flags_[index_] = SUPPRESSED;
+            return false;
+          }
+          return true;
+        }
+        EntropyTable& table_;
+        unsigned index_;
+    };
+
+    //! Sums up the entropy of all nodes without artificial points
+    struct EntropyMeanAccumulator
+    {
+        EntropyMeanAccumulator(const EntropyTable& table) : table_(table), summedMean_(0.0), count_(0) { }
+        bool operator()(Node* node)
+        {
+          if( node->fixed().getPointFlag() != ARTIFICIAL )
+          {
+            summedMean_ += table_.entropy_[node->index()];
+            count_++;
+          }
+          return true;
+        }
+        const EntropyTable& table_;
+        Scalar summedMean_;
+        int count_;
+    };
+
+    //! Sums up the squared entropy deviation of all nodes without artificial points
+    struct EntropyVarianceAccumulator
+    {
+        EntropyVarianceAccumulator(const EntropyTable& table, Scalar mean) : table_(table), mean_(mean), summedVariance_(0.0) { }
+        bool operator()(Node* node)
+        {
+          if( node->fixed().getPointFlag() != ARTIFICIAL )
+          {
+            Scalar entropy = table_.entropy_[node->index()];
+            summedVariance_ += (entropy - mean_) * (entropy - mean_);
+          }
+          return true;
+        }
+        const EntropyTable& table_;
+        Scalar mean_;
+        Scalar summedVariance_;
+    };
+
+    //! Sums up the node positions with an entropy above the mean, weighted with a gaussian kernel
+    struct MeanShiftAccumulator
+    {
+        MeanShiftAccumulator(const EntropyTable& table, Scalar mean, Scalar variance) : table_(table), mean_(mean), variance_(variance), shiftedPosition_(Vector3::Zero()), summedShift_(0.0) { }
+        bool operator()(Node* node)
+        {
+          Scalar entropy = table_.entropy_[node->index()];
+          if( entropy > mean_ )
+          {
+            Scalar entropyDifference = mean_ - entropy;
+            Scalar kernelElements = (entropyDifference*entropyDifference) / (variance_);
+            shiftedPosition_ += node->fixed().getMeanPosition() * exp(-0.5*kernelElements);
+            summedShift_ += exp(-0.5*kernelElements);
+          }
+          return true;
+        }
+        const EntropyTable& table_;
+        Scalar mean_, variance_;
+        Vector3 shiftedPosition_;
+        Scalar summedShift_;
+    };
 
 
   } // namespace
@@ -0,0 +1,138 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_NEIGHBORHOOD_CACHE_H_
+#define SURE_NEIGHBORHOOD_CACHE_H_
+
+#include <vector>
+
+#include <sure/data/typedef.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/octree/octree_node.h>
+#include <sure/octree/octree.h>
+
+namespace sure
+{
+  namespace keypoints
+  {
+
+    //! Appends all visited nodes to a list
+    struct NeighborCollector
+    {
+        typedef sure::octree::Node<sure::payload::PointMoments> Node;
+
+        NeighborCollector(std::vector<Node*>& nodes) : nodes_(nodes) { }
+        bool operator()(Node* node) { nodes_.push_back(node); return true; }
+        std::vector<Node*>& nodes_;
+    };
+
+    /**
+     * Stores the neighborhood of every octree node of a single depth in compressed sparse row form.
+     * The neighborhood of a node contains all nodes of the same depth overlapping the box with the given unit radius around
+     * the node's center, in the order Octree::forEachNodeIn visits them. Thus visiting the cached neighborhood gives the same
+     * results as querying the octree, but without descending the tree.
+     */
+    class NeighborhoodCache
+    {
+      public:
+
+        typedef sure::payload::PointMoments FixedPayload;
+        typedef sure::octree::Node<FixedPayload> Node;
+        typedef sure::octree::Octree<FixedPayload> Octree;
+        typedef Octree::NodeVector NodeVector;
+
+        NeighborhoodCache() : octree_(NULL), depth_(0), unitRadius_(0) { }
+
+        /**
+         * Collects the neighborhoods of all nodes of a depth. The octree must not change while the cache is used.
+         * Memory of a former cache is reused.
+         * @param octree
+         * @param depth
+         * @param unitRadius Half edge length of the box around every node in octree units
+         * @param threads Number of worker threads, zero selects all available threads
+         */
+        void build(const Octree& octree, unsigned depth, unsigned unitRadius, int threads = 0);
+
+        //! Empties the cache, but keeps its memory
+        void clear();
+
+        bool empty() const { return octree_ == NULL; }
+
+        //! Checks wether the cache holds the neighborhoods of the given octree, depth and radius
+        bool contains(const Octree& octree, unsigned depth, unsigned unitRadius) const
+        {
+          return octree_ == &octree && depth_ == depth && unitRadius_ == unitRadius;
+        }
+
+        //! Number of neighbors of the node with the given index in its depth
+        unsigned getNumberOfNeighbors(unsigned index) const { return offsets_[index+1] - offsets_[index]; }
+
+        /**
+         * Calls the visitor for every neighbor of the node with the given index in its depth, until it returns false
+         * @return False, if the visitor stopped the iteration
+         */
+        template <typename VisitorT>
+        bool forEachNeighbor(unsigned index, VisitorT& f) const
+        {
+          for(unsigned i=offsets_[index]; i<offsets_[index+1]; ++i)
+          {
+            if( !f(neighbors_[i]) )
+            {
+              return false;
+            }
+          }
+          return true;
+        }
+
+        //! Allocated memory in bytes
+        size_t memory() const;
+
+      protected:
+
+        const Octree* octree_;
+        unsigned depth_;
+        unsigned unitRadius_;
+
+        //! Position of the first neighbor of every node in neighbors_, with one element past the end
+        std::vector<unsigned> offsets_;
+        NodeVector neighbors_;
+
+        //! Neighbors collected by every thread during the build
+        std::vector<NodeVector> threadNeighbors_;
+    };
+
+  } // namespace
+} // namespace
+
+#endif /* SURE_NEIGHBORHOOD_CACHE_H_ */
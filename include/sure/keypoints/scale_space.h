@@ -0,0 +1,139 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_SCALE_SPACE_H_
+#define SURE_SCALE_SPACE_H_
+
+#include <vector>
+
+#include <sure/data/typedef.h>
+#include <sure/access/region.h>
+#include <sure/normal/normal_histogram.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
+#include <sure/octree/octree_node.h>
+#include <sure/octree/octree.h>
+#include <sure/octree/morton.h>
+
+namespace sure
+{
+  namespace keypoints
+  {
+
+    /**
+     * Pyramid of aggregated normal histograms for calculating the entropy on multiple scales.
+     * It is built once from the normal table of all nodes at the normal depth and stores the summed histogram of
+     * every octree node above that depth. Integrating the histograms in a box adds the sums of all nodes fully
+     * contained in the box and only descends to the normal depth along its border, so larger scales need
+     * comparatively fewer lookups.
+     *
+     * The integrated histograms equal octree.integrateSideTable(region, normalDepth, normals.histograms_, sum) except
+     * for floating point rounding, since the summation order differs.
+     */
+    class ScaleSpacePyramid
+    {
+      public:
+
+        typedef sure::payload::PointMoments FixedPayload;
+        typedef sure::octree::Node<FixedPayload> Node;
+        typedef sure::octree::Octree<FixedPayload> Octree;
+        typedef Octree::NodeVector NodeVector;
+        typedef sure::payload::NormalTable NormalTable;
+        typedef sure::normal::NormalHistogram NormalHistogram;
+        typedef sure::octree::MortonKey MortonKey;
+        typedef sure::access::Region Region;
+        typedef sure::access::Point Point;
+
+        ScaleSpacePyramid() : octree_(NULL), normals_(NULL), depth_(0) { }
+
+        /**
+         * Builds the pyramid from the histograms of a normal table, the nodes of the table's depth are the normal nodes.
+         * The octree and its normals must not change while the pyramid is used. Memory of a former pyramid is reused.
+         * @param threads Number of worker threads, zero selects all available threads
+         */
+        void build(const Octree& octree, const NormalTable& normals, int threads = 0);
+
+        //! Empties the pyramid, but keeps its memory
+        void clear();
+
+        bool empty() const { return nodes_.empty(); }
+
+        //! Depth of the normal nodes
+        unsigned getDepth() const { return depth_; }
+
+        /**
+         * Adds the histograms of all normal nodes overlapping with a box to histogram.
+         * Returns the number of added histograms, an aggregated histogram counts once.
+         */
+        unsigned integrate(const Vector3& point, Scalar radius, NormalHistogram& histogram) const
+        {
+          return integrate(Region(octree_->getAddress(point), octree_->getUnitSize(radius)), histogram);
+        }
+        unsigned integrate(const Region& r, NormalHistogram& histogram) const;
+
+      protected:
+
+        //! Aggregated nodes of a single depth, ordered by their morton keys
+        struct Level
+        {
+            std::vector<MortonKey> keys;
+            std::vector<unsigned> children;   //!< Index of the first child in the next deeper level, with one element past the end
+            std::vector<NormalHistogram> sums;
+        };
+
+        //! Region of a node addressed by its morton key in a given depth
+        Region getRegion(MortonKey key, unsigned depth) const;
+
+        static const unsigned MAX_TRAVERSAL_DEPTH = 32;
+        static const unsigned TRAVERSAL_STACK_SIZE = (OCTANT-1) * MAX_TRAVERSAL_DEPTH + 1;
+
+        const Octree* octree_;
+        const NormalTable* normals_;
+        unsigned depth_;
+        Point origin_;
+
+        //! Levels above the normal depth, levels_[0] contains the root
+        std::vector<Level> levels_;
+
+        //! Normal nodes and their keys ordered by their morton keys
+        std::vector<MortonKey> keys_;
+        NodeVector nodes_;
+
+        std::vector<sure::octree::MortonIndex> sorted_, buffer_;
+    };
+
+  } // namespace
+} // namespace
+
+#endif /* SURE_SCALE_SPACE_H_ */
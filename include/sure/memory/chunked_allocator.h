@@ -0,0 +1,271 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_MEMORY_CHUNKED_ALLOCATOR_H_
+#define SURE_MEMORY_CHUNKED_ALLOCATOR_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <ostream>
+#include <iostream>
+
+namespace sure
+{
+  namespace memory
+  {
+
+    /**
+     * A templated slab allocator growing in chunks of fixed size. Template Type must have a public default constructor.
+     * Blocks larger than the chunk size get a dedicated chunk of their size.
+     * Chunks are never moved, so pointers stay valid while the allocator grows. Memory is released only due to a resize,
+     * release or deconstruction.
+     * Provides the interface of FixedSizeAllocator, but the capacity is a reservation hint instead of a limit.
+     * Clearing is O(1): Elements handed out before are reset to T() when they are allocated again.
+     */
+    template<typename T>
+    class ChunkedAllocator
+    {
+
+      public:
+
+        static const std::size_t DEFAULT_CHUNK_SIZE = 4096;
+
+        ChunkedAllocator(std::size_t chunkSize = DEFAULT_CHUNK_SIZE) : chunkSize_(chunkSize ? chunkSize : 1), current_(NULL), end_(NULL),
+          capacity_(0), nextChunk_(0), size_(0), used_(0), highWaterMark_(0), generation_(0)
+        {
+        }
+
+        ~ChunkedAllocator()
+        {
+          release();
+        }
+
+        /**
+         * Returns a pointer to the template type. Adds a chunk, if all chunks are in use.
+         * May throw a bad_alloc, if no more memory is available.
+         */
+        T* allocate() throw (std::exception)
+        {
+          if( current_ == end_ )
+          {
+            nextChunk(1);
+          }
+          if( size_ < used_ )
+          {
+            *current_ = T();
+          }
+          else
+          {
+            used_ = size_+1;
+          }
+          size_++;
+          if( size_ > highWaterMark_ )
+          {
+            highWaterMark_ = size_;
+          }
+          return current_++;
+        }
+
+        /**
+         * Returns a pointer to count consecutive elements, e.g. as a slab for a single thread. The rest of the current chunk is
+         * skipped, if it is too small, as are reserved chunks smaller than count. May throw a bad_alloc.
+         */
+        T* allocate(std::size_t count) throw (std::exception)
+        {
+          if( current_ + count > end_ )
+          {
+            size_ += end_ - current_;
+            nextChunk(count);
+          }
+          T* first = current_;
+          for(std::size_t i=0; i<count; ++i, ++current_, ++size_)
+          {
+            if( size_ < used_ )
+            {
+              *current_ = T();
+            }
+            else
+            {
+              used_ = size_+1;
+            }
+          }
+          if( size_ > highWaterMark_ )
+          {
+            highWaterMark_ = size_;
+          }
+          return first;
+        }
+
+        //! Has no effect.
+        void deallocate(T* ptr) { }
+
+        //! Starts a new generation in O(1). Pointers remain valid, but their elements will be reused by the next allocations
+        void clear()
+        {
+          size_ = 0;
+          nextChunk_ = 0;
+          current_ = end_ = NULL;
+          generation_++;
+        }
+
+        /**
+         * Reservation hint: Adds chunks until the capacity is at least the given number of elements. Pointers remain valid.
+         * May throw a bad_alloc.
+         */
+        void reserve(std::size_t capacity) throw (std::exception)
+        {
+          while( capacity_ < capacity )
+          {
+            addChunk(chunkSize_);
+          }
+        }
+
+        //! Reserves the given capacity and clears the allocator. Pointers remain valid. May throw a bad_alloc
+        void resizeIfSmaller(std::size_t newCapacity) throw (std::exception)
+        {
+          reserve(newCapacity);
+          clear();
+        }
+
+        //! Releases all chunks and reserves the given capacity. Renders all pointers invalid. May throw a bad_alloc.
+        void resize(std::size_t newCapacity) throw (std::exception)
+        {
+          release();
+          reserve(newCapacity);
+        }
+
+        //! Releases all chunks. Renders all pointers invalid.
+        void release()
+        {
+          for(unsigned int i=0; i<chunks_.size(); ++i)
+          {
+            delete[] chunks_[i];
+          }
+          chunks_.clear();
+          chunkSizes_.clear();
+          capacity_ = nextChunk_ = 0;
+          size_ = used_ = 0;
+          current_ = end_ = NULL;
+          generation_++;
+        }
+
+        //! Return the used elements
+        std::size_t size() const { return size_; }
+
+        //! Return the number of elements in all chunks
+        std::size_t capacity() const { return capacity_; }
+
+        //! Number of elements handed out at least once since the last release
+        std::size_t used() const { return used_; }
+
+        //! Maximum number of elements used at the same time since construction
+        std::size_t highWaterMark() const { return highWaterMark_; }
+
+        //! Number of elements per chunk, except for chunks of larger blocks
+        std::size_t chunkSize() const { return chunkSize_; }
+
+        //! Number of allocated chunks
+        std::size_t numberOfChunks() const { return chunks_.size(); }
+
+        //! Memory held by the chunks in bytes
+        std::size_t memory() const { return capacity() * sizeof(T); }
+
+        //! Incremented by every clear, resize or release
+        unsigned generation() const { return generation_; }
+
+      protected:
+
+        /**
+         * Moves to the next chunk holding at least count elements. Smaller chunks are skipped and count as used, a chunk is
+         * added if none is left. Elements keep their position across generations, as chunks are always used in the same order
+         */
+        void nextChunk(std::size_t count) throw (std::exception)
+        {
+          while( nextChunk_ < chunks_.size() && chunkSizes_[nextChunk_] < count )
+          {
+            size_ += chunkSizes_[nextChunk_++];
+          }
+          if( size_ > used_ )
+          {
+            used_ = size_;
+          }
+          if( nextChunk_ == chunks_.size() )
+          {
+            addChunk(std::max(count, chunkSize_));
+          }
+          current_ = chunks_[nextChunk_];
+          end_ = current_ + chunkSizes_[nextChunk_];
+          nextChunk_++;
+        }
+
+        //! Appends a chunk of the given size. May throw a bad_alloc
+        void addChunk(std::size_t size) throw (std::exception)
+        {
+          chunks_.reserve(chunks_.size() + 1);
+          chunkSizes_.reserve(chunks_.size() + 1);
+          chunks_.push_back(new T[size]);
+          chunkSizes_.push_back(size);
+          capacity_ += size;
+        }
+
+        std::vector<T*> chunks_;
+        std::vector<std::size_t> chunkSizes_;
+        std::size_t chunkSize_;
+        T* current_;
+        T* end_;
+        std::size_t capacity_, nextChunk_;
+        std::size_t size_, used_, highWaterMark_;
+        unsigned generation_;
+
+      private:
+
+        ChunkedAllocator(const ChunkedAllocator& rhs)
+        {
+          throw std::bad_alloc();
+        }
+
+    };
+
+    template<typename T>
+    std::ostream& operator<<(std::ostream& stream, const ChunkedAllocator<T>& rhs)
+    {
+      return stream << "Chunked allocator - size " << rhs.size() << " - capacity: " << rhs.capacity() << " in " << rhs.numberOfChunks() << " chunks - high water mark: " << rhs.highWaterMark() << "\n";
+    }
+
+  }
+}
+
+#endif /* SURE_MEMORY_CHUNKED_ALLOCATOR_H_ */
@@ -48,6 +48,7 @@ namespace sure
      * A templated allocator with fixed size. Template Type must have a public default constructor.
      * Any aquired memory will be released only due to a resize or deconstruction.
      * Throws bad_alloc if its capacity is reached.
+     * Clearing is O(1): Elements handed out before are reset to T() when they are allocated again.
      */
     template<typename T>
     class FixedSizeAllocator
@@ -55,14 +56,14 @@ namespace sure
 
       public:
 
-        FixedSizeAllocator() : array_(NULL), current_(NULL), size_(0), capacity_(0)
+        FixedSizeAllocator() : array_(NULL), current_(NULL), size_(0), capacity_(0), used_(0), highWaterMark_(0), generation_(0)
         {
         }
 
         /**
          * Initializes the Allocator with the given capacity. May throw a bad_alloc.
          */
-        FixedSizeAllocator(std::size_t capacity) : array_(NULL), current_(NULL), size_(0), capacity_(0)
+        FixedSizeAllocator(std::size_t capacity) : array_(NULL), current_(NULL), size_(0), capacity_(0), used_(0), highWaterMark_(0), generation_(0)
         {
           resize(capacity);
         }
@@ -86,22 +87,60 @@ namespace sure
           {
             throw std::bad_alloc();
           }
+          if( size_ < used_ )
+          {
+            *current_ = T();
+          }
+          else
+          {
+            used_ = size_+1;
+          }
           size_++;
+          if( size_ > highWaterMark_ )
+          {
+            highWaterMark_ = size_;
+          }
           return current_++;
         }
 
+        /**
+         * Returns a pointer to count consecutive elements, e.g. as a slab for a single thread.
+         * May throw if the allocator is not initialized or its capacity is reached.
+         */
+        T* allocate(std::size_t count) throw (std::exception)
+        {
+          if( !current_ || size_ + count > capacity_ )
+          {
+            throw std::bad_alloc();
+          }
+          T* first = current_;
+          for(std::size_t i=0; i<count; ++i, ++current_, ++size_)
+          {
+            if( size_ < used_ )
+            {
+              *current_ = T();
+            }
+            else
+            {
+              used_ = size_+1;
+            }
+          }
+          if( size_ > highWaterMark_ )
+          {
+            highWaterMark_ = size_;
+          }
+          return first;
+        }
+
         //! Has no effect.
         void deallocate(T* ptr) { }
 
-        //! Calls default constructor to all allocated elements. Pointers remain valid
+        //! Starts a new generation in O(1). Pointers remain valid, but their elements will be reused by the next allocations
         void clear()
         {
-          for(unsigned int i=0; i<size_; ++i)
-          {
-            array_[i] = T();
-          }
           size_ = 0;
-          current_ = &array_[0];
+          current_ = array_;
+          generation_++;
         }
 
         /**
@@ -129,8 +168,10 @@ namespace sure
             array_ = NULL;
           }
           array_ = new T[newCapacity];
-          current_ = &array_[0];
+          current_ = array_;
+          size_ = used_ = 0;
           capacity_ = newCapacity;
+          generation_++;
         }
 
         //! Return the used elements
@@ -139,11 +180,24 @@ namespace sure
         //! Return the capacity
         std::size_t capacity() const { return capacity_; }
 
+        //! Number of elements handed out at least once since the last resize
+        std::size_t used() const { return used_; }
+
+        //! Maximum number of elements used at the same time since construction
+        std::size_t highWaterMark() const { return highWaterMark_; }
+
+        //! Memory held by the allocator in bytes
+        std::size_t memory() const { return capacity_ * sizeof(T); }
+
+        //! Incremented by every clear or resize
+        unsigned generation() const { return generation_; }
+
       protected:
 
         T* array_;
         T* current_;
-        std::size_t size_, capacity_;
+        std::size_t size_, capacity_, used_, highWaterMark_;
+        unsigned generation_;
 
       private:
 
@@ -157,7 +211,7 @@ namespace sure
     template<typename T>
     std::ostream& operator<<(std::ostream& stream, const FixedSizeAllocator<T>& rhs)
     {
-      return stream << "Fixed size allocator - size " << rhs.size() << " - capacity: " << rhs.capacity() << "\n";
+      return stream << "Fixed size allocator - size " << rhs.size() << " - capacity: " << rhs.capacity() << " - generation: " << rhs.generation() << "\n";
     }
 
   }
@@ -37,6 +37,7 @@
 #include <cstddef>
 #include <new>
 #include <ostream>
+#include <vector>
 
 namespace sure
 {
@@ -47,6 +48,8 @@ namespace sure
      * Allows indexed access to its elements and does not keep track of the elements used.
      * Any aquired memory will be released only due to a resize or deconstruction.
      * Throws bad_alloc if its capacity is reached.
+     * Clearing is O(1): Every element stores the generation it was allocated in and is reset to T(),
+     * if it is allocated again in a later generation.
      */
     template<typename T>
     class FixedSizeAllocatorWithDirectAccess
@@ -54,8 +57,8 @@ namespace sure
 
       public:
 
-        FixedSizeAllocatorWithDirectAccess() : array_(NULL), capacity_(0) { }
-        FixedSizeAllocatorWithDirectAccess(std::size_t capacity) : array_(NULL), capacity_(0)
+        FixedSizeAllocatorWithDirectAccess() : array_(NULL), capacity_(0), generation_(1) { }
+        FixedSizeAllocatorWithDirectAccess(std::size_t capacity) : array_(NULL), capacity_(0), generation_(1)
         {
           resize(capacity);
         }
@@ -75,19 +78,24 @@ namespace sure
           {
             throw std::bad_alloc();
           }
+          if( elementGeneration_[index] != generation_ )
+          {
+            if( elementGeneration_[index] )
+            {
+              array_[index] = T();
+            }
+            elementGeneration_[index] = generation_;
+          }
           return &array_[index];
         }
 
         void deallocate(T* ptr) { }
         void deallocate(unsigned index) { array_[index] = T(); }
 
-        //! Calls default constructor to all allocated elements. Pointers remain valid
+        //! Starts a new generation in O(1). Pointers remain valid, but their elements will be reset when allocated again
         void clear()
         {
-          for(unsigned int i=0; i<capacity_; ++i)
-          {
-            array_[i] = T();
-          }
+          generation_++;
         }
 
         /**
@@ -115,17 +123,25 @@ namespace sure
             array_ = NULL;
           }
           array_ = new T[newCapacity+1];
+          elementGeneration_.assign(newCapacity+1, 0);
           capacity_ = newCapacity;
         }
 
         //! Return the capacity
         std::size_t capacity() const { return capacity_; }
 
+        //! Incremented by every clear
+        unsigned generation() const { return generation_; }
+
       protected:
 
         T* array_;
         std::size_t capacity_;
 
+        //! Generation of the last allocation for every element, zero for elements never allocated
+        std::vector<unsigned> elementGeneration_;
+        unsigned generation_;
+
       private:
 
         FixedSizeAllocatorWithDirectAccess(const FixedSizeAllocatorWithDirectAccess& rhs)
@@ -42,6 +42,7 @@
 #include <pcl/point_types.h>
 
 #include <sure/data/typedef.h>
+#include <sure/normal/histogram_kernel.h>
 
 namespace sure
 {
@@ -125,8 +126,11 @@ namespace sure
 
       protected:
 
-        //! calculates the raw entropy of the histogram
-        HistoType calculateRawEntropy() const;
+        /**
+         * calculates the raw entropy of the histogram
+         * @param approximate Uses a vectorized approximation of the logarithm, see calculateApproximateEntropy for its error bound
+         */
+        HistoType calculateRawEntropy(bool approximate = false) const;
 
         //! the histogram
         HistoType values_[HistogramSize];
@@ -61,7 +61,7 @@ namespace sure
 
         void insertCrossProduct(const NormalType& referenceNormal, const NormalType& secondNormal);
 
-        HistoType calculateEntropy() const { return calculateRawEntropy() / MAX_ENTROPY; }
+        HistoType calculateEntropy(bool approximate = false) const { return calculateRawEntropy(approximate) / MAX_ENTROPY; }
 
       protected:
 
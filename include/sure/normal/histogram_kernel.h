@@ -0,0 +1,117 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_HISTOGRAM_KERNEL_H_
+#define SURE_HISTOGRAM_KERNEL_H_
+
+#include <sure/data/typedef.h>
+
+namespace sure
+{
+
+  namespace normal
+  {
+
+    //! Number of reference directions rounded up to a multiple of eight floats, the width of an AVX register
+    const int PADDED_HISTOGRAM_SIZE = ((NORMAL_HISTOGRAM_SIZE + 7) / 8) * 8;
+
+    /**
+     * Single precision copy of the reference vectors used for the histogram bins, stored as structure of arrays.
+     * Entries beyond NORMAL_HISTOGRAM_SIZE are zero.
+     */
+    struct ReferenceDirections
+    {
+        float x[PADDED_HISTOGRAM_SIZE] __attribute__((aligned(32)));
+        float y[PADDED_HISTOGRAM_SIZE] __attribute__((aligned(32)));
+        float z[PADDED_HISTOGRAM_SIZE] __attribute__((aligned(32)));
+    };
+
+    //! Returns the reference directions, which are built on the first call
+    const ReferenceDirections& getReferenceDirections();
+
+    /**
+     * Implementations of the histogram kernels, i.e. the bin weights and the approximate entropy
+     */
+    enum HistogramKernel
+    {
+      SCALAR_HISTOGRAM_KERNEL = 0,//!< SCALAR_HISTOGRAM_KERNEL Plain C++, available everywhere
+      SSE_HISTOGRAM_KERNEL,       //!< SSE_HISTOGRAM_KERNEL Four bins per instruction
+      AVX2_HISTOGRAM_KERNEL       //!< AVX2_HISTOGRAM_KERNEL Eight bins per instruction
+    };
+
+    //! Checks wether the kernel was compiled in and is supported by the cpu
+    bool isHistogramKernelSupported(HistogramKernel kernel);
+
+    //! Returns the kernel used for histogram insertion and approximate entropy. Defaults to the fastest kernel supported by the cpu
+    HistogramKernel getHistogramKernel();
+
+    //! Sets the kernel used for histogram insertion and approximate entropy. Returns false and keeps the current kernel if it is not supported
+    bool setHistogramKernel(HistogramKernel kernel);
+
+    /**
+     * Weights a direction against all reference directions with the current kernel.
+     * A bin gets the weight (d - c) / (1 - c), where d is the dot product with its reference direction and c is the cosine of the influence radius,
+     * if d is greater than c and zero otherwise.
+     * @param direction Normalized direction, a non-finite direction results in zero weights
+     * @param influenceRadius Cosine of the influence radius
+     * @param weights Receives PADDED_HISTOGRAM_SIZE weights, the ones beyond NORMAL_HISTOGRAM_SIZE are zero
+     */
+    void calculateBinWeights(const NormalType& direction, Scalar influenceRadius, HistoType* weights);
+
+    //! Same as above with a given kernel, which needs to be supported
+    void calculateBinWeights(HistogramKernel kernel, const NormalType& direction, Scalar influenceRadius, HistoType* weights);
+
+    //! Upper bound for the absolute error of the approximated base 2 logarithm
+    const HistoType APPROXIMATE_LOG2_MAX_ERROR = 1.5e-5;
+
+    /**
+     * Approximates the entropy -sum(p * log2(p)) of a histogram with the current kernel, where p = values[i] / weight and all p not greater than EPSILON are skipped.
+     * The logarithm is split into the exponent and a fifth degree polynomial of the mantissa with an absolute error below APPROXIMATE_LOG2_MAX_ERROR.
+     * The absolute error of the entropy is therefore below APPROXIMATE_LOG2_MAX_ERROR times the sum of all p, which is one if the weight is the sum of the values,
+     * plus single precision rounding.
+     * @param values The histogram values
+     * @param size Number of values
+     * @param weight Total weight of the histogram, needs to be greater than zero
+     * @return The entropy in bits
+     */
+    HistoType calculateApproximateEntropy(const HistoType* values, int size, HistoType weight);
+
+    //! Same as above with a given kernel, which needs to be supported
+    HistoType calculateApproximateEntropy(HistogramKernel kernel, const HistoType* values, int size, HistoType weight);
+
+  } // namespace
+
+} // namespace
+
+#endif /* SURE_HISTOGRAM_KERNEL_H_ */
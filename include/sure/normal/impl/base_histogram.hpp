@@ -116,10 +116,14 @@ void sure::normal::BaseHistogram<HistogramSize>::clear()
 //}
 
 template <int HistogramSize>
-sure::HistoType sure::normal::BaseHistogram<HistogramSize>::calculateRawEntropy() const
+sure::HistoType sure::normal::BaseHistogram<HistogramSize>::calculateRawEntropy(bool approximate) const
 {
   HistoType entropy(0.f);
-  if( weight_ > 0.f )
+  if( weight_ > 0.f && approximate )
+  {
+    entropy = calculateApproximateEntropy(values_, HistogramSize, weight_);
+  }
+  else if( weight_ > 0.f )
   {
     HistoType sum = 0.f;
     for(int i=0; i<HistogramSize; ++i)
@@ -36,11 +36,10 @@
 
 #include <Eigen/Dense>
 
-#include <sure/memory/fixed_size_allocator_direct_access.h>
 #include <sure/normal/normal.h>
 #include <sure/normal/normal_histogram.h>
-#include <sure/payload/payload_xyzrgb.h>
-#include <sure/payload/payload_normal.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
 #include <sure/octree/octree_node.h>
 #include <sure/octree/octree.h>
 
@@ -48,21 +47,20 @@ namespace sure
 {
   namespace normal
   {
-    typedef sure::payload::PointsRGB PointsRGB;
-    typedef sure::octree::Node<PointsRGB> Node;
-    typedef sure::octree::Octree<PointsRGB> Octree;
+    typedef sure::payload::PointMoments FixedPayload;
+    typedef sure::octree::Node<FixedPayload> Node;
+    typedef sure::octree::Octree<FixedPayload> Octree;
     typedef Octree::NodeVector NodeVector;
-    typedef sure::payload::NormalPayload NormalPayload;
-    typedef sure::payload::PointsRGB FixedPayload;
+    typedef sure::payload::NormalTable NormalTable;
     typedef sure::PointFlag PointFlag;
 
     /**
-     * Allocates the optional payload for storing normals to all octree nodes with a given edge length
+     * Resets the side table for storing normals to all octree nodes with a given edge length
      * @param octree
      * @param samplingrate Defines the edge length of the octree nodes
-     * @param allocator The allocator which allocates and owns the normal payload
+     * @param normals The table which stores the normals of the nodes
      */
-    void allocateNormalPayload(Octree& octree, Scalar samplingrate, sure::memory::FixedSizeAllocatorWithDirectAccess<NormalPayload>& allocator);
+    void allocateNormalPayload(Octree& octree, Scalar samplingrate, NormalTable& normals);
 
     /**
      * Orientates a given normal toward a given orientation point, usually the viewpoint
@@ -85,20 +83,23 @@ namespace sure
     /**
      * Estimated normals in the octree on all nodes with an edge length corresponding to the samplingrate
      * @param octree
+     * @param normals Receives the normals, allocated for the samplingrate
      * @param samplingrate
      * @param radius Radius of the box around a designated normal position in which all point information will be integrated
      * @param orientationPoint Any normal will be orientated towards this point
      * @param histogramInfluence Determines the range on the unit sphere's surface a normal will influence the underlying histogram
+     * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
      */
-    unsigned estimateNormals(Octree& octree, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence);
+    unsigned estimateNormals(Octree& octree, NormalTable& normals, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence, int threads = 0);
 
     /**
      * Sets normals from nodes with a given flag as invalid
      * @param octree
+     * @param normals Allocated for the samplingrate
      * @param samplingrate
      * @param flag
      */
-    unsigned discardNormalsfromNodesWithFlag(Octree& octree, Scalar samplingrate, PointFlag flag);
+    unsigned discardNormalsfromNodesWithFlag(Octree& octree, NormalTable& normals, Scalar samplingrate, PointFlag flag);
 
   }
 }
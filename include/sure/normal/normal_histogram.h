@@ -64,7 +64,7 @@ namespace sure
         void insertNormal(const NormalType& normal);
         void insertNormal(const Normal& normal) { insertNormal(normal.vector()); }
 
-        HistoType calculateEntropy() const { return calculateRawEntropy() / MAX_ENTROPY; }
+        HistoType calculateEntropy(bool approximate = false) const { return calculateRawEntropy(approximate) / MAX_ENTROPY; }
 
       protected:
 
@@ -0,0 +1,151 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_ORGANIZED_NORMAL_ESTIMATION_H_
+#define SURE_ORGANIZED_NORMAL_ESTIMATION_H_
+
+#include <vector>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+#include <sure/data/range_image.h>
+#include <sure/normal/normal_estimation.h>
+
+namespace sure
+{
+  namespace normal
+  {
+    typedef pcl::PointCloud<pcl::PointXYZRGB> OrganizedCloud;
+    typedef sure::range_image::RangeImage<pcl::PointXYZRGB> RangeImage;
+
+    /**
+     * Integral images of the point moments of an organized point cloud. The moments of any window of pixels are summed
+     * in constant time. Octree positions are mapped to pixels with a pinhole camera model, which is fitted to the cloud.
+     * Positions are integrated relative to the sensor origin in double precision.
+     */
+    class IntegralMomentImage
+    {
+      public:
+
+        //! Number of values per pixel: points, depth border pixels, three first and six second moments
+        static const int CHANNELS = 11;
+
+        //! Maximum mean deviation in pixels of the fitted camera model
+        static const Scalar MAX_PROJECTION_ERROR;
+
+        //! Distance between the pixels used for fitting the camera model
+        static const int FIT_STEP = 4;
+
+        //! Number of columns integrated together
+        static const int STRIP_SIZE = 64;
+
+        IntegralMomentImage() : width_(0), height_(0), valid_(false) { }
+
+        /**
+         * Builds the integral images. Fails, if the cloud is not organized or does not follow a pinhole camera model
+         * @param cloud
+         * @param rangeImage Depth borders of the cloud
+         * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
+         * @return True, if the images can be used for integration
+         */
+        bool build(const OrganizedCloud& cloud, const RangeImage& rangeImage, int threads = 0);
+
+        void clear() { width_ = height_ = 0; valid_ = false; }
+
+        bool valid() const { return valid_; }
+
+        /**
+         * Integrates the points around a position within a window corresponding to a box with the given radius.
+         * Positions behind other surfaces, windows touching a depth border and windows whose points have a standard deviation
+         * above the radius along any axis are rejected, since the window would not resemble the box. The deviation test is
+         * only a necessary condition: accepted windows may still contain some points outside of the box.
+         * @param p
+         * @param radius
+         * @param payload Receives the moments, relative to the sensor origin
+         * @return True, if the window was integrated, false if the octree has to be used
+         */
+        bool integrate(const Vector3& p, Scalar radius, FixedPayload& payload) const;
+
+      protected:
+
+        //! Adds the moments of a pixel to sums and returns its distance from the sensor origin, infinite for invalid pixels
+        float addPixel(const pcl::PointXYZRGB& point, bool border, double* sums) const;
+
+        //! Sums of all pixels in the inclusive window
+        void sum(int x0, int y0, int x1, int y1, double* values) const;
+
+        const double* at(int x, int y) const { return &table_[((std::size_t) y * (width_+1) + x) * CHANNELS]; }
+
+        /**
+         * Fits one axis of the camera model with least squares, pixel = focal * coordinate / depth + center
+         * @return False, if the mean deviation exceeds MAX_PROJECTION_ERROR
+         */
+        static bool fitAxis(const std::vector<Scalar>& coordinates, const std::vector<Scalar>& pixels, Scalar& focal, Scalar& center);
+
+        std::vector<double> table_;
+
+        //! Sums of all pixels left of every strip of columns in every row
+        std::vector<double> stripSums_;
+
+        //! Distance of every pixel from the sensor origin, infinite for invalid pixels
+        std::vector<float> ranges_;
+
+        int width_, height_;
+        bool valid_;
+
+        Vector3 origin_;
+        Matrix3 toCamera_;
+        Scalar focal_[2], center_[2];
+
+    };
+
+    /**
+     * Estimates normals like estimateNormals, but integrates the points with the integral images where possible
+     * @param octree
+     * @param normals Receives the normals, allocated for the samplingrate
+     * @param image Valid integral images of the point cloud inserted into the octree
+     * @param samplingrate
+     * @param radius Radius of the box around a designated normal position in which all point information will be integrated
+     * @param orientationPoint Any normal will be orientated towards this point
+     * @param histogramInfluence Determines the range on the unit sphere's surface a normal will influence the underlying histogram
+     * @param imageNormals Receives the number of normals integrated with the images
+     * @param threads Number of worker threads, zero selects all available threads. Results do not depend on it
+     */
+    unsigned estimateNormals(Octree& octree, NormalTable& normals, const IntegralMomentImage& image, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence, unsigned& imageNormals, int threads = 0);
+
+  }
+}
+
+#endif /* SURE_ORGANIZED_NORMAL_ESTIMATION_H_ */
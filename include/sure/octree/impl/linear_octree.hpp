@@ -0,0 +1,359 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+template <typename FixedPayloadT>
+void sure::octree::LinearOctree<FixedPayloadT>::clear()
+{
+  levels_.clear();
+  maxDepth_ = 0;
+  minimumNodeSize_ = DEFAULT_MINIMUM_NODE_SIZE;
+  maxNodeResolution_ = DEFAULT_MINIMUM_NODE_SIZE / (Scalar) DEFAULT_MIN_NODE_UNIT_SIZE;
+  octreeCenter_ = Vector3::Zero();
+  initialized_ = false;
+}
+
+template <typename FixedPayloadT>
+bool sure::octree::LinearOctree<FixedPayloadT>::initialize(Scalar minNodeSize, Scalar expansion, const Vector3& center)
+{
+  clear();
+
+  minimumNodeSize_ = minNodeSize;
+  octreeCenter_ = center;
+
+  unsigned dimension;
+  dimension = (expansion / minimumNodeSize_) * (float) DEFAULT_MIN_NODE_UNIT_SIZE;
+  if( dimension < DEFAULT_MIN_NODE_UNIT_SIZE )
+  {
+    return initialized_;
+  }
+  if( dimension >= 8 && dimension % 8 != 0 )
+  {
+    return initialized_;
+  }
+
+  maxDepth_ = 0;
+  while( fabs(expansion - minimumNodeSize_) > std::numeric_limits<float>::epsilon() )
+  {
+    expansion *= 0.5f;
+    maxDepth_++;
+  }
+  if( maxDepth_ > MAX_MORTON_DEPTH )
+  {
+    return initialized_;
+  }
+
+  rootRegion_ = Region(Point(0, 0, 0), dimension/2);
+  rootMin_ = rootRegion_.min();
+
+  levels_.resize(maxDepth_+1);
+  levels_[0].keys.push_back(0);
+  levels_[0].payload.resize(1);
+  if( maxDepth_ > 0 )
+  {
+    levels_[0].children.resize(2, 0);
+  }
+
+  initialized_ = true;
+  return initialized_;
+}
+
+template <typename FixedPayloadT>
+unsigned sure::octree::LinearOctree<FixedPayloadT>::getChild(unsigned depth, unsigned index, OctantType octant) const
+{
+  if( depth >= maxDepth_ )
+  {
+    return INVALID_INDEX;
+  }
+  const Level& level = levels_[depth];
+  const KeyVector& childKeys = levels_[depth+1].keys;
+  const MortonKey childKey = (level.keys[index] << 3) | (~((MortonKey) octant) & (MortonKey) 7);
+  for(unsigned k=level.children[index]; k<level.children[index+1]; ++k)
+  {
+    if( childKeys[k] == childKey )
+    {
+      return k;
+    }
+  }
+  return INVALID_INDEX;
+}
+
+template <typename FixedPayloadT>
+unsigned sure::octree::LinearOctree<FixedPayloadT>::getNode(const Point& a, unsigned depth) const
+{
+  if( depth == 0 )
+  {
+    depth = maxDepth_;
+  }
+  if( !rootRegion_.contains(a) )
+  {
+    return INVALID_INDEX;
+  }
+  return findKey(depth, getMortonKey(a, depth));
+}
+
+template <typename FixedPayloadT>
+typename sure::octree::LinearOctree<FixedPayloadT>::IndexVector sure::octree::LinearOctree<FixedPayloadT>::getNodes(const Region& r, unsigned depth) const
+{
+  IndexVector v;
+  depth = std::min(depth, maxDepth_);
+  if( depth == 0 )
+  {
+    if( rootRegion_.overlaps(r) )
+    {
+      v.push_back(0);
+    }
+    return v;
+  }
+
+  // Depth-first search, children are pushed in reverse order so the result is in morton order.
+  // Every depth adds at most eight entries to the stack.
+  unsigned stackDepth[OCTANT * MAX_MORTON_DEPTH + 1];
+  unsigned stackIndex[OCTANT * MAX_MORTON_DEPTH + 1];
+  int top(0);
+  stackDepth[0] = 0;
+  stackIndex[0] = 0;
+  while( top >= 0 )
+  {
+    const unsigned currDepth = stackDepth[top];
+    const unsigned currIndex = stackIndex[top];
+    top--;
+
+    const unsigned first = levels_[currDepth].children[currIndex];
+    for(unsigned k=levels_[currDepth].children[currIndex+1]; k-- > first; )
+    {
+      if( getRegion(levels_[currDepth+1].keys[k], currDepth+1).overlaps(r) )
+      {
+        if( currDepth+1 == depth )
+        {
+          v.push_back(k);
+        }
+        else
+        {
+          top++;
+          stackDepth[top] = currDepth+1;
+          stackIndex[top] = k;
+        }
+      }
+    }
+  }
+  std::reverse(v.begin(), v.end());
+  return v;
+}
+
+template <typename FixedPayloadT>
+unsigned sure::octree::LinearOctree<FixedPayloadT>::integratePayload(const Region& r, FixedPayloadT& payload) const
+{
+  unsigned count(0);
+  if( maxDepth_ == 0 )
+  {
+    return count;
+  }
+
+  unsigned stackDepth[OCTANT * MAX_MORTON_DEPTH + 1];
+  unsigned stackIndex[OCTANT * MAX_MORTON_DEPTH + 1];
+  int top(0);
+  stackDepth[0] = 0;
+  stackIndex[0] = 0;
+  while( top >= 0 )
+  {
+    const unsigned currDepth = stackDepth[top];
+    const unsigned currIndex = stackIndex[top];
+    top--;
+
+    const Level& level = levels_[currDepth];
+    if( r.contains(getRegion(level.keys[currIndex], currDepth)) )
+    {
+      payload += level.payload[currIndex];
+      count++;
+      continue;
+    }
+
+    const Level& children = levels_[currDepth+1];
+    for(unsigned k=level.children[currIndex]; k<level.children[currIndex+1]; ++k)
+    {
+      if( !r.overlaps(getRegion(children.keys[k], currDepth+1)) )
+      {
+        continue;
+      }
+      if( currDepth < maxDepth_-1 )
+      {
+        top++;
+        stackDepth[top] = currDepth+1;
+        stackIndex[top] = k;
+      }
+      else
+      {
+        payload += children.payload[k];
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+template <typename FixedPayloadT>
+template <typename PointT>
+void sure::octree::LinearOctree<FixedPayloadT>::insertPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag)
+{
+  if( cloud.size() == 0 )
+  {
+    std::cout << "Pointcloud empty, skipping octree building.\n";
+    return;
+  }
+  const int threads = sure::getNumberOfThreads(threads_);
+  const int size = cloud.size();
+  const MortonKey invalidKey = (MortonKey) 1 << (3 * maxDepth_);
+
+  std::vector<MortonIndex> points(size);
+
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for(int i=0; i<size; ++i)
+  {
+    const PointT& p = cloud.points[i];
+    points[i].index = i;
+    points[i].key = std::isfinite(p.x) ? getMortonKey(getAddress(p.x, p.y, p.z), maxDepth_) : invalidKey;
+  }
+
+  KeyVector keys;
+  IndexVector begin;
+  groupMortonIndices(points, invalidKey, keys, begin, threads);
+
+  const int numberOfLeaves = keys.size();
+  PayloadVector payload(numberOfLeaves);
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for(int j=0; j<numberOfLeaves; ++j)
+  {
+    for(unsigned k=begin[j]; k<begin[j+1]; ++k)
+    {
+      const unsigned index = points[k].index;
+      const PointT& p = cloud.points[index];
+      FixedPayloadT point;
+      point.setPosition(p.x, p.y, p.z);
+      point.setColor(p.rgb);
+      point.setFlag(flag);
+      if( rangeImage && rangeImage->isBackgroundBorder(index) )
+      {
+        point.setFlag(BACKGROUND_BORDER);
+      }
+      if( rangeImage && rangeImage->isForegroundBorder(index) )
+      {
+        point.setFlag(FOREGROUND_BORDER);
+      }
+      payload[j] += point;
+    }
+  }
+
+  mergeLeaves(keys, payload);
+}
+
+template <typename FixedPayloadT>
+void sure::octree::LinearOctree<FixedPayloadT>::mergeLeaves(KeyVector& keys, PayloadVector& payload)
+{
+  const int threads = sure::getNumberOfThreads(threads_);
+  Level& leaves = levels_[maxDepth_];
+  if( leaves.keys.empty() )
+  {
+    leaves.keys.swap(keys);
+    leaves.payload.swap(payload);
+  }
+  else
+  {
+    KeyVector mergedKeys;
+    PayloadVector mergedPayload;
+    mergedKeys.reserve(leaves.keys.size() + keys.size());
+    mergedPayload.reserve(leaves.keys.size() + keys.size());
+    unsigned i(0), j(0);
+    while( i < leaves.keys.size() || j < keys.size() )
+    {
+      if( j == keys.size() || (i < leaves.keys.size() && leaves.keys[i] < keys[j]) )
+      {
+        mergedKeys.push_back(leaves.keys[i]);
+        mergedPayload.push_back(leaves.payload[i++]);
+      }
+      else if( i == leaves.keys.size() || keys[j] < leaves.keys[i] )
+      {
+        mergedKeys.push_back(keys[j]);
+        mergedPayload.push_back(payload[j++]);
+      }
+      else
+      {
+        mergedKeys.push_back(keys[j]);
+        mergedPayload.push_back(leaves.payload[i++]);
+        mergedPayload.back() += payload[j++];
+      }
+    }
+    leaves.keys.swap(mergedKeys);
+    leaves.payload.swap(mergedPayload);
+  }
+
+  // Rebuild the higher levels, siblings are neighbors in morton order
+  for(int depth=maxDepth_-1; depth>=0; --depth)
+  {
+    Level& level = levels_[depth];
+    const Level& children = levels_[depth+1];
+    const unsigned numberOfChildren = children.keys.size();
+
+    level.keys.clear();
+    level.children.clear();
+    for(unsigned k=0; k<numberOfChildren; ++k)
+    {
+      MortonKey parentKey = children.keys[k] >> 3;
+      if( k == 0 || parentKey != level.keys.back() )
+      {
+        level.keys.push_back(parentKey);
+        level.children.push_back(k);
+      }
+    }
+    if( level.keys.empty() )
+    {
+      // the root always exists
+      level.keys.push_back(0);
+      level.children.push_back(0);
+    }
+    level.children.push_back(numberOfChildren);
+
+    const int numberOfNodes = level.keys.size();
+    level.payload.assign(numberOfNodes, FixedPayloadT());
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+    for(int j=0; j<numberOfNodes; ++j)
+    {
+      for(unsigned k=level.children[j]; k<level.children[j+1]; ++k)
+      {
+        level.payload[j] += children.payload[k];
+      }
+    }
+  }
+}
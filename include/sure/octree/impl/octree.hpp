@@ -63,149 +63,98 @@ void sure::octree::Octree<FixedPayloadT>::clear()
   maxDepth_ = 0;
   minimumNodeSize_ = DEFAULT_MINIMUM_NODE_SIZE;
   octreeCenter_ = Vector3::Zero();
-  map_.clear();
-  initialized_ = false;
-}
-
-template <typename FixedPayloadT>
-typename sure::octree::Octree<FixedPayloadT>::NodeVector sure::octree::Octree<FixedPayloadT>::getNodes(const Region& r) const
-{
-  NodeVector v;
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+  if( reuseMemory_ )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
-    if( r.contains(current->region()) )
-    {
-      v.push_back(current);
-    }
-    else if( current->depth() < maxDepth_-1 )
+    for(typename LevelMap::iterator it=map_.begin(); it!=map_.end(); ++it)
     {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
-        {
-          nodeList.push_back(current->children_[i]);
-        }
-      }
-    }
-    else
-    {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
-        {
-          v.push_back(current->children_[i]);
-        }
-      }
+      it->second.clear();
     }
   }
-  return v;
+  else
+  {
+    map_.clear();
+    threadPayload_.clear();
+  }
+  invalidateSummedVolumeTables();
+  initialized_ = false;
 }
 
 template <typename FixedPayloadT>
-typename sure::octree::Octree<FixedPayloadT>::NodeVector sure::octree::Octree<FixedPayloadT>::getNodes(const Region& r, unsigned depth) const
+void sure::octree::Octree<FixedPayloadT>::invalidateSummedVolumeTables()
 {
-  NodeVector v;
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+  if( reuseMemory_ )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
-    unsigned currDepth = current->depth();
-
-    if( currDepth < depth-1 )
+    for(typename VolumeTableMap::iterator it=tables_.begin(); it!=tables_.end(); ++it)
     {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && current->children_[i]->region().overlaps(r) )
-        {
-          nodeList.push_back(current->children_[i]);
-        }
-      }
-    }
-    else
-    {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && current->children_[i]->region().overlaps(r) )
-        {
-          v.push_back(current->children_[i]);
-        }
-      }
+      it->second.clear();
     }
   }
-  return v;
+  else
+  {
+    tables_.clear();
+  }
+  builtTables_.assign(maxDepth_+1, (const VolumeTable*) NULL);
 }
 
 template <typename FixedPayloadT>
-unsigned sure::octree::Octree<FixedPayloadT>::integratePayload(const Region& r, FixedPayloadT& payload) const
+const typename sure::octree::Octree<FixedPayloadT>::VolumeTable* sure::octree::Octree<FixedPayloadT>::getSummedVolumeTable(unsigned depth) const
 {
-  unsigned count(0);
-
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+  if( tableLimit_ == 0 || !root_ || depth > maxDepth_ )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
-    if( r.contains(current->region_) )
-    {
-      payload += current->fixed_;
-      count++;
-    }
-    else if( current->depth() < maxDepth_-1 )
+    return NULL;
+  }
+  // built tables are published per depth, so concurrent queries only lock while a table is missing
+  const VolumeTable* table = (depth < builtTables_.size()) ? __atomic_load_n(&builtTables_[depth], __ATOMIC_ACQUIRE) : NULL;
+  if( !table )
+  {
+#pragma omp critical(sure_octree_volume_table)
     {
-      for(unsigned i=0; i<OCTANT; ++i)
+      VolumeTable& newTable = tables_[depth];
+      if( !newTable.built() )
       {
-        if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
-        {
-          nodeList.push_back(current->children_[i]);
-        }
+        typename LevelMap::const_iterator level = map_.find(depth);
+        newTable.build(level != map_.end() ? level->second : NodeVector(), root_->region().min(), getUnitSizeFromDepth(depth), tableLimit_);
       }
-    }
-    else
-    {
-      for(unsigned i=0; i<OCTANT; ++i)
+      table = &newTable;
+      if( depth < builtTables_.size() )
       {
-        if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
-        {
-          payload += current->children_[i]->fixed();
-          count++;
-        }
+        __atomic_store_n(&builtTables_[depth], table, __ATOMIC_RELEASE);
       }
     }
   }
-  return count;
+  return table->valid() ? table : NULL;
 }
 
 template <typename FixedPayloadT>
-unsigned sure::octree::Octree<FixedPayloadT>::integratePayload(const Region& r, unsigned depth, FixedPayloadT& payload) const
+template <typename VisitorT>
+bool sure::octree::Octree<FixedPayloadT>::forEachNodeIn(const Region& r, unsigned depth, VisitorT& f) const
 {
-  unsigned count(0);
+  Node* stack[TRAVERSAL_STACK_SIZE];
+  unsigned char stackDepth[TRAVERSAL_STACK_SIZE];
+  unsigned size(0);
+
+  if( !root_ )
+  {
+    return true;
+  }
+  stack[size] = root_;
+  stackDepth[size++] = 0;
 
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+  while( size > 0 )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
-    unsigned currDepth = current->depth();
+    size--;
+    Node* current = stack[size];
+    unsigned currDepth = stackDepth[size];
 
     if( currDepth < depth-1 )
     {
-      for(unsigned i=0; i<OCTANT; ++i)
+      // children are pushed in reverse order, so the nodes are visited in the same order as a breadth-first search would
+      for(int i=OCTANT-1; i>=0; --i)
       {
         if( current->children_[i] && current->children_[i]->region().overlaps(r) )
         {
-          nodeList.push_back(current->children_[i]);
+          stack[size] = current->children_[i];
+          stackDepth[size++] = currDepth+1;
         }
       }
     }
@@ -215,43 +164,53 @@ unsigned sure::octree::Octree<FixedPayloadT>::integratePayload(const Region& r,
       {
         if( current->children_[i] && current->children_[i]->region().overlaps(r) )
         {
-          payload += current->fixed_;
-          count++;
+          if( !f(current->children_[i]) )
+          {
+            return false;
+          }
         }
       }
     }
   }
-  return count;
+  return true;
 }
 
 template <typename FixedPayloadT>
-template <typename OptionalPayloadT>
-unsigned sure::octree::Octree<FixedPayloadT>::integrateOptionalPayload(const Region& r, OptionalPayloadT& payload) const
+template <typename VisitorT>
+bool sure::octree::Octree<FixedPayloadT>::forEachNodeWithin(const Region& r, VisitorT& f) const
 {
-  unsigned count(0);
+  Node* stack[TRAVERSAL_STACK_SIZE];
+  unsigned char stackDepth[TRAVERSAL_STACK_SIZE];
+  unsigned size(0);
+
+  if( !root_ )
+  {
+    return true;
+  }
+  stack[size] = root_;
+  stackDepth[size++] = 0;
 
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+  while( size > 0 )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
+    size--;
+    Node* current = stack[size];
+    unsigned currDepth = stackDepth[size];
+
     if( r.contains(current->region_) )
     {
-      if( current->opt() )
+      if( !f(current) )
       {
-        payload += *(static_cast<OptionalPayloadT*>(current->opt()));
-        count++;
+        return false;
       }
     }
-    else if( current->depth() < maxDepth_-1 )
+    else if( currDepth < maxDepth_-1 )
     {
-      for(unsigned i=0; i<OCTANT; ++i)
+      for(int i=OCTANT-1; i>=0; --i)
       {
         if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
         {
-          nodeList.push_back(current->children_[i]);
+          stack[size] = current->children_[i];
+          stackDepth[size++] = currDepth+1;
         }
       }
     }
@@ -261,59 +220,69 @@ unsigned sure::octree::Octree<FixedPayloadT>::integrateOptionalPayload(const Reg
       {
         if( current->children_[i] && r.overlaps(current->children_[i]->region()) )
         {
-          if( current->children_[i]->opt() )
+          if( !f(current->children_[i]) )
           {
-            payload += *(static_cast<OptionalPayloadT*>(current->children_[i]->opt()));
-            count++;
+            return false;
           }
         }
       }
     }
   }
-  return count;
+  return true;
+}
+
+template <typename FixedPayloadT>
+typename sure::octree::Octree<FixedPayloadT>::NodeVector sure::octree::Octree<FixedPayloadT>::getNodes(const Region& r) const
+{
+  NodeVector v;
+  NodeCollector collector(v);
+  forEachNodeWithin(r, collector);
+  return v;
 }
 
 template <typename FixedPayloadT>
-template <typename OptionalPayloadT>
-unsigned sure::octree::Octree<FixedPayloadT>::integrateOptionalPayload(const Region& r, unsigned depth, OptionalPayloadT& payload) const
+typename sure::octree::Octree<FixedPayloadT>::NodeVector sure::octree::Octree<FixedPayloadT>::getNodes(const Region& r, unsigned depth) const
 {
-  unsigned count(0);
+  NodeVector v;
+  NodeCollector collector(v);
+  forEachNodeIn(r, depth, collector);
+  return v;
+}
 
-  std::deque<Node*> nodeList;
-  nodeList.push_back(root_);
-  Node* current;
-  while( !nodeList.empty() )
+template <typename FixedPayloadT>
+unsigned sure::octree::Octree<FixedPayloadT>::integratePayload(const Region& r, FixedPayloadT& payload) const
+{
+  // the nodes within the region cover exactly the leaves overlapping it
+  const VolumeTable* table = getSummedVolumeTable(maxDepth_);
+  if( table )
   {
-    current = nodeList.front();
-    nodeList.pop_front();
-    unsigned currDepth = current->depth();
+    return table->integrate(r, payload);
+  }
+  PayloadIntegrator integrator(payload);
+  forEachNodeWithin(r, integrator);
+  return integrator.count_;
+}
 
-    if( currDepth < depth-1 )
-    {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && current->children_[i]->region().overlaps(r) )
-        {
-          nodeList.push_back(current->children_[i]);
-        }
-      }
-    }
-    else
-    {
-      for(unsigned i=0; i<OCTANT; ++i)
-      {
-        if( current->children_[i] && current->children_[i]->region().overlaps(r) )
-        {
-          if( current->children_[i]->opt() )
-          {
-            payload += *(static_cast<OptionalPayloadT*>(current->children_[i]->opt()));
-            count++;
-          }
-        }
-      }
-    }
+template <typename FixedPayloadT>
+unsigned sure::octree::Octree<FixedPayloadT>::integratePayload(const Region& r, unsigned depth, FixedPayloadT& payload) const
+{
+  const VolumeTable* table = getSummedVolumeTable(depth);
+  if( table )
+  {
+    return table->integrate(r, payload);
   }
-  return count;
+  PayloadIntegrator integrator(payload);
+  forEachNodeIn(r, depth, integrator);
+  return integrator.count_;
+}
+
+template <typename FixedPayloadT>
+template <typename ValueT, typename AllocatorT>
+unsigned sure::octree::Octree<FixedPayloadT>::integrateSideTable(const Region& r, unsigned depth, const std::vector<ValueT, AllocatorT>& values, ValueT& sum) const
+{
+  SideTableIntegrator<ValueT, AllocatorT> integrator(values, sum);
+  forEachNodeIn(r, depth, integrator);
+  return integrator.count_;
 }
 
 /**
@@ -403,7 +372,14 @@ bool sure::octree::Octree<FixedPayloadT>::initialize(Scalar minNodeSize, Scalar
     maxDepth_++;
   }
 
-  allocator_.resize(capacity);
+  if( reuseMemory_ )
+  {
+    allocator_.resizeIfSmaller(capacity);
+  }
+  else
+  {
+    allocator_.resize(capacity);
+  }
 
   root_ = NULL;
   root_ = allocator_.allocate();
@@ -413,22 +389,33 @@ bool sure::octree::Octree<FixedPayloadT>::initialize(Scalar minNodeSize, Scalar
   }
   root_->region_ = Region(Point(0, 0, 0), dimension/2);
 
-  map_.clear();
+  root_->index_ = 0;
   map_[0].push_back(root_);
 
   initialized_ = true;
   return initialized_;
 }
 
-template <>
+template <typename FixedPayloadT>
 template <typename PointT>
-void sure::octree::Octree<sure::payload::PointsRGB>::addPointCloud(const pcl::PointCloud<PointT>& cloud)
+void sure::octree::Octree<FixedPayloadT>::addPointCloud(const pcl::PointCloud<PointT>& cloud)
 {
+  invalidateSummedVolumeTables();
   if( cloud.size() == 0 )
   {
     std::cout << "Pointcloud empty, skipping octree building.\n";
     return;
   }
+  if( useSortedInsertion() )
+  {
+    insertSortedPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, NORMAL);
+    return;
+  }
+  if( useConcurrentInsertion() )
+  {
+    insertConcurrentPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, NORMAL);
+    return;
+  }
   for(unsigned int i=0; i<cloud.size(); ++i)
   {
     const PointT& p = cloud.at(i);
@@ -445,15 +432,26 @@ void sure::octree::Octree<sure::payload::PointsRGB>::addPointCloud(const pcl::Po
   }
 }
 
-template <>
+template <typename FixedPayloadT>
 template <typename PointT>
-void sure::octree::Octree<sure::payload::PointsRGB>::addPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>& rangeImage)
+void sure::octree::Octree<FixedPayloadT>::addPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>& rangeImage)
 {
+  invalidateSummedVolumeTables();
   if( cloud.size() == 0 )
   {
     std::cout << "Pointcloud empty, skipping octree building.\n";
     return;
   }
+  if( useSortedInsertion() )
+  {
+    insertSortedPointCloud(cloud, &rangeImage, NORMAL);
+    return;
+  }
+  if( useConcurrentInsertion() )
+  {
+    insertConcurrentPointCloud(cloud, &rangeImage, NORMAL);
+    return;
+  }
   for(unsigned int i=0; i<cloud.size(); ++i)
   {
     const PointT& p = cloud.at(i);
@@ -478,15 +476,26 @@ void sure::octree::Octree<sure::payload::PointsRGB>::addPointCloud(const pcl::Po
   }
 }
 
-template <>
+template <typename FixedPayloadT>
 template <typename PointT>
-void sure::octree::Octree<sure::payload::PointsRGB>::addArtificialPointCloud(const pcl::PointCloud<PointT>& cloud)
+void sure::octree::Octree<FixedPayloadT>::addArtificialPointCloud(const pcl::PointCloud<PointT>& cloud)
 {
+  invalidateSummedVolumeTables();
   if( cloud.size() == 0 )
   {
     std::cout << "Pointcloud empty, skipping octree building.\n";
     return;
   }
+  if( useSortedInsertion() )
+  {
+    insertSortedPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, ARTIFICIAL);
+    return;
+  }
+  if( useConcurrentInsertion() )
+  {
+    insertConcurrentPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, ARTIFICIAL);
+    return;
+  }
   for(unsigned int i=0; i<cloud.size(); ++i)
   {
     const PointT& p = cloud.at(i);
@@ -516,9 +525,446 @@ void sure::octree::Octree<FixedPayloadT>::insertNode(Node* current, const Node&
       current->children_[octant] = allocator_.allocate();
       current->children_[octant]->region_ = current->region_.getOctant(octant);
       current->children_[octant]->parent_ = current;
+      current->children_[octant]->index_ = map_[level+1].size();
       map_[level+1].push_back(current->children_[octant]);
     }
     level++;
     insertNode(current->children_[octant], node, level);
   }
 }
+
+template <typename FixedPayloadT>
+template <typename PointT>
+void sure::octree::Octree<FixedPayloadT>::insertSortedPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag)
+{
+  const int threads = sure::getNumberOfThreads(threads_);
+  const int size = cloud.size();
+  const MortonKey invalidKey = (MortonKey) 1 << (3 * maxDepth_);
+
+  std::vector<MortonIndex> points(size);
+
+#pragma omp parallel for schedule(static) num_threads(threads)
+  for(int i=0; i<size; ++i)
+  {
+    const PointT& p = cloud.points[i];
+    points[i].index = i;
+    points[i].key = std::isfinite(p.x) ? getMortonKey(getAddress(p.x, p.y, p.z)) : invalidKey;
+  }
+
+  std::vector<SortedLevel> levels(maxDepth_+1);
+  SortedLevel& leaves = levels[maxDepth_];
+  groupMortonIndices(points, invalidKey, leaves.keys, leaves.begin, threads);
+  leaves.first.resize(leaves.keys.size());
+  for(unsigned j=0; j<leaves.keys.size(); ++j)
+  {
+    leaves.first[j] = points[leaves.begin[j]].index;
+  }
+
+  linkSortedLevels(levels, size);
+
+  const int numberOfLeaves = leaves.nodes.size();
+  PayloadVector payload(numberOfLeaves);
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+  for(int j=0; j<numberOfLeaves; ++j)
+  {
+    // The sort is stable, so the points of a leaf are added in the same order as by insertNode
+    for(unsigned k=leaves.begin[j]; k<leaves.begin[j+1]; ++k)
+    {
+      const unsigned index = points[k].index;
+      const PointT& p = cloud.points[index];
+      FixedPayloadT point;
+      point.setPosition(p.x, p.y, p.z);
+      point.setColor(p.rgb);
+      point.setFlag(flag);
+      if( rangeImage && rangeImage->isBackgroundBorder(index) )
+      {
+        point.setFlag(BACKGROUND_BORDER);
+      }
+      if( rangeImage && rangeImage->isForegroundBorder(index) )
+      {
+        point.setFlag(FOREGROUND_BORDER);
+      }
+      payload[j] += point;
+    }
+  }
+
+  mergeSortedPayload(levels, payload);
+}
+
+template <typename FixedPayloadT>
+void sure::octree::Octree<FixedPayloadT>::linkSortedLevels(std::vector<SortedLevel>& levels, unsigned numberOfPoints)
+{
+  // Bottom-up: siblings are neighbors in morton order, so every parent is a run of equal shifted keys
+  for(unsigned depth=maxDepth_; depth>1; --depth)
+  {
+    SortedLevel& children = levels[depth];
+    SortedLevel& parents = levels[depth-1];
+    const unsigned numberOfChildren = children.keys.size();
+
+    children.parent.resize(numberOfChildren);
+    for(unsigned j=0; j<numberOfChildren; ++j)
+    {
+      MortonKey parentKey = children.keys[j] >> 3;
+      if( j == 0 || parentKey != parents.keys.back() )
+      {
+        parents.begin.push_back(j);
+        parents.keys.push_back(parentKey);
+        parents.first.push_back(children.first[j]);
+      }
+      else
+      {
+        parents.first.back() = std::min(parents.first.back(), children.first[j]);
+      }
+      children.parent[j] = parents.keys.size() - 1;
+    }
+    parents.begin.push_back(numberOfChildren);
+  }
+  levels[1].parent.assign(levels[1].keys.size(), 0);
+
+  // Top-down: link the nodes into the tree. New nodes are appended to the level map in the order of the first point
+  // reaching them, which is the order resulting from insertNode. As the first point indices of a level are unique,
+  // every level is ordered by sorting its own nodes along them.
+  const int threads = sure::getNumberOfThreads(threads_);
+  unsigned indexBits(1);
+  while( indexBits < 32 && (numberOfPoints >> indexBits) )
+  {
+    indexBits++;
+  }
+  std::vector<MortonIndex> order, buffer;
+  NodeVector root(1, root_);
+  for(unsigned depth=1; depth<=maxDepth_; ++depth)
+  {
+    SortedLevel& level = levels[depth];
+    const NodeVector& parentNodes = (depth == 1) ? root : levels[depth-1].nodes;
+    const unsigned numberOfNodes = level.keys.size();
+
+    order.resize(numberOfNodes);
+    for(unsigned j=0; j<numberOfNodes; ++j)
+    {
+      order[j].key = level.first[j];
+      order[j].index = j;
+    }
+    sortMortonIndices(order, buffer, indexBits, threads);
+
+    level.nodes.resize(numberOfNodes);
+    for(unsigned i=0; i<numberOfNodes; ++i)
+    {
+      const unsigned j = order[i].index;
+      Node* parent = parentNodes[level.parent[j]];
+      OctantType octant = getMortonOctant(level.keys[j]);
+      if( !parent->children_[octant] )
+      {
+        parent->children_[octant] = allocator_.allocate();
+        parent->children_[octant]->region_ = parent->region_.getOctant(octant);
+        parent->children_[octant]->parent_ = parent;
+        parent->children_[octant]->index_ = map_[depth].size();
+        map_[depth].push_back(parent->children_[octant]);
+      }
+      level.nodes[j] = parent->children_[octant];
+    }
+    std::vector<MortonKey>().swap(level.keys);
+  }
+}
+
+template <typename FixedPayloadT>
+void sure::octree::Octree<FixedPayloadT>::mergeSortedPayload(std::vector<SortedLevel>& levels, PayloadVector& payload)
+{
+  const int threads = sure::getNumberOfThreads(threads_);
+  PayloadVector parentPayload;
+  for(unsigned depth=maxDepth_; depth>0; --depth)
+  {
+    SortedLevel& level = levels[depth];
+    const int numberOfNodes = level.nodes.size();
+
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for(int j=0; j<numberOfNodes; ++j)
+    {
+      level.nodes[j]->fixed_ += payload[j];
+    }
+
+    if( depth == 1 )
+    {
+      for(int j=0; j<numberOfNodes; ++j)
+      {
+        root_->fixed_ += payload[j];
+      }
+      break;
+    }
+
+    const SortedLevel& parents = levels[depth-1];
+    const int numberOfParents = parents.nodes.size();
+    parentPayload.assign(numberOfParents, FixedPayloadT());
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+    for(int j=0; j<numberOfParents; ++j)
+    {
+      for(unsigned k=parents.begin[j]; k<parents.begin[j+1]; ++k)
+      {
+        parentPayload[j] += payload[k];
+      }
+    }
+    payload.swap(parentPayload);
+  }
+}
+
+template <typename FixedPayloadT>
+template <typename PointT>
+void sure::octree::Octree<FixedPayloadT>::insertConcurrentPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag)
+{
+  const int threads = sure::getNumberOfThreads(threads_);
+  const int size = cloud.size();
+
+  if( (int) threadPayload_.size() < threads )
+  {
+    threadPayload_.resize(threads);
+  }
+  for(int t=0; t<threads; ++t)
+  {
+    threadPayload_[t].clear(maxDepth_+1);
+  }
+
+  // An exception must not leave the parallel region, it stops all threads and is rethrown afterwards
+  bool failed(false), outOfMemory(false);
+  std::string message;
+
+  // Every thread inserts a contiguous block of points, so the points of a thread are visited in ascending order
+#pragma omp parallel num_threads(threads)
+  {
+    int thread = 0, numberOfThreads = 1;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+    numberOfThreads = omp_get_num_threads();
+#endif
+    ThreadPayload& local = threadPayload_[thread];
+    const int begin = (int) (((long long) size * thread) / numberOfThreads);
+    const int end = (int) (((long long) size * (thread+1)) / numberOfThreads);
+
+    // Consecutive points mostly share their paths, so the entries of the last path are kept
+    NodeVector path(maxDepth_+1, (Node*) NULL);
+    std::vector<unsigned> entries(maxDepth_+1, 0);
+
+    try
+    {
+      for(int i=begin; i<end && !__atomic_load_n(&failed, __ATOMIC_RELAXED); ++i)
+      {
+        const PointT& p = cloud.points[i];
+        if( !std::isfinite(p.x) )
+        {
+          continue;
+        }
+        FixedPayloadT point;
+        point.setPosition(p.x, p.y, p.z);
+        point.setColor(p.rgb);
+        point.setFlag(flag);
+        if( rangeImage && rangeImage->isBackgroundBorder(i) )
+        {
+          point.setFlag(BACKGROUND_BORDER);
+        }
+        if( rangeImage && rangeImage->isForegroundBorder(i) )
+        {
+          point.setFlag(FOREGROUND_BORDER);
+        }
+
+        const Point center(Region(getAddress(p.x, p.y, p.z), DEFAULT_MIN_NODE_UNIT_RADIUS).center());
+        Node* current = root_;
+        for(unsigned depth=0; ; ++depth)
+        {
+          if( current != path[depth] )
+          {
+            path[depth] = current;
+            entries[depth] = local.getEntry(current, i);
+          }
+          local.sums[entries[depth]] += point;
+          if( depth == maxDepth_ )
+          {
+            break;
+          }
+          current = getOrCreateChild(current, current->region_.getOctant(center), depth+1, local);
+        }
+      }
+    }
+    catch(std::bad_alloc&)
+    {
+      __atomic_store_n(&outOfMemory, true, __ATOMIC_RELAXED);
+      __atomic_store_n(&failed, true, __ATOMIC_RELAXED);
+    }
+    catch(std::exception& e)
+    {
+#pragma omp critical(sure_octree_insertion_error)
+      {
+        message = e.what();
+      }
+      __atomic_store_n(&failed, true, __ATOMIC_RELAXED);
+    }
+  }
+
+  if( outOfMemory )
+  {
+    throw std::bad_alloc();
+  }
+  if( failed )
+  {
+    throw std::runtime_error(message);
+  }
+
+  // Within a table every node is unique, the tables are merged in thread order
+  for(int t=0; t<threads; ++t)
+  {
+    ThreadPayload& local = threadPayload_[t];
+    const int numberOfEntries = local.nodes.size();
+
+#pragma omp parallel for schedule(static) num_threads(threads)
+    for(int j=0; j<numberOfEntries; ++j)
+    {
+      local.nodes[j]->fixed_ += local.sums[j];
+    }
+  }
+
+  // New nodes are appended to the level map in the order of the first point reaching them, which is the order resulting
+  // from insertNode. As the blocks are ascending, the first point is found in the first table containing the node.
+  std::vector<std::pair<unsigned, Node*> > order;
+  for(unsigned depth=1; depth<=maxDepth_; ++depth)
+  {
+    order.clear();
+    for(int t=0; t<threads; ++t)
+    {
+      const NodeVector& created = threadPayload_[t].created[depth];
+      for(unsigned j=0; j<created.size(); ++j)
+      {
+        order.push_back(std::make_pair(0u, created[j]));
+      }
+    }
+    const int numberOfNodes = order.size();
+
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+    for(int j=0; j<numberOfNodes; ++j)
+    {
+      for(int t=0; t<threads; ++t)
+      {
+        const int entry = threadPayload_[t].find(order[j].second);
+        if( entry >= 0 )
+        {
+          order[j].first = threadPayload_[t].first[entry];
+          break;
+        }
+      }
+    }
+
+    std::sort(order.begin(), order.end());
+    NodeVector& level = map_[depth];
+    level.reserve(level.size() + numberOfNodes);
+    for(int j=0; j<numberOfNodes; ++j)
+    {
+      order[j].second->index_ = level.size();
+      level.push_back(order[j].second);
+    }
+  }
+}
+
+template <typename FixedPayloadT>
+typename sure::octree::Octree<FixedPayloadT>::Node* sure::octree::Octree<FixedPayloadT>::getOrCreateChild(Node* current, OctantType octant, unsigned depth, ThreadPayload& local)
+{
+  // Pairs with the compare-and-swap, so the region of a child published by another thread is visible
+  Node* child = __atomic_load_n(&current->children_[octant], __ATOMIC_ACQUIRE);
+  if( child )
+  {
+    return child;
+  }
+  if( local.slabSize == 0 )
+  {
+#pragma omp critical(sure_octree_node_pool)
+    {
+      local.slab = allocator_.allocate(NODE_SLAB_SIZE);
+    }
+    local.slabSize = NODE_SLAB_SIZE;
+  }
+
+  // The node is initialized before it is published, a thread losing the race keeps it in its slab
+  child = local.slab;
+  child->region_ = current->region_.getOctant(octant);
+  child->parent_ = current;
+  if( __sync_bool_compare_and_swap(&current->children_[octant], (Node*) NULL, child) )
+  {
+    local.slab++;
+    local.slabSize--;
+    local.created[depth].push_back(child);
+    return child;
+  }
+  return __atomic_load_n(&current->children_[octant], __ATOMIC_ACQUIRE);
+}
+
+template <typename FixedPayloadT>
+void sure::octree::Octree<FixedPayloadT>::ThreadPayload::clear(unsigned depths)
+{
+  std::fill(table.begin(), table.end(), -1);
+  nodes.clear();
+  sums.clear();
+  first.clear();
+  created.resize(depths);
+  for(unsigned d=0; d<depths; ++d)
+  {
+    created[d].clear();
+  }
+  slab = NULL;
+  slabSize = 0;
+}
+
+template <typename FixedPayloadT>
+unsigned sure::octree::Octree<FixedPayloadT>::ThreadPayload::getEntry(Node* node, unsigned pointIndex)
+{
+  if( 2 * (nodes.size() + 1) > table.size() )
+  {
+    rehash(std::max((std::size_t) 1024, 2 * table.size()));
+  }
+  const std::size_t mask = table.size() - 1;
+  for(std::size_t k=hash(node) & mask; ; k=(k+1) & mask)
+  {
+    if( table[k] < 0 )
+    {
+      table[k] = nodes.size();
+      nodes.push_back(node);
+      sums.push_back(FixedPayloadT());
+      first.push_back(pointIndex);
+      return table[k];
+    }
+    if( nodes[table[k]] == node )
+    {
+      return table[k];
+    }
+  }
+}
+
+template <typename FixedPayloadT>
+int sure::octree::Octree<FixedPayloadT>::ThreadPayload::find(Node* node) const
+{
+  if( table.empty() )
+  {
+    return -1;
+  }
+  const std::size_t mask = table.size() - 1;
+  for(std::size_t k=hash(node) & mask; table[k] >= 0; k=(k+1) & mask)
+  {
+    if( nodes[table[k]] == node )
+    {
+      return table[k];
+    }
+  }
+  return -1;
+}
+
+template <typename FixedPayloadT>
+void sure::octree::Octree<FixedPayloadT>::ThreadPayload::rehash(std::size_t tableSize)
+{
+  table.assign(tableSize, -1);
+  const std::size_t mask = tableSize - 1;
+  for(unsigned j=0; j<nodes.size(); ++j)
+  {
+    std::size_t k = hash(nodes[j]) & mask;
+    while( table[k] >= 0 )
+    {
+      k = (k+1) & mask;
+    }
+    table[k] = j;
+  }
+}
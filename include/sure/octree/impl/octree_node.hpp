@@ -41,28 +41,8 @@ std::ostream& sure::octree::operator<<(std::ostream& stream, Node<FixedPayloadT>
   {
     stream << (rhs.children_[i] ? 1 : 0);
   }
-  stream << " - parent: " << (rhs.parent_ ? 1 : 0) << "\n";
+  stream << " - parent: " << (rhs.parent_ ? 1 : 0) << " - index: " << rhs.index_ << "\n";
   stream << rhs.fixed();
-  if( rhs.opt() )
-  {
-    sure::payload::Payload* payload = rhs.opt();
-    if( dynamic_cast<sure::payload::NormalPayload*>(payload) )
-    {
-      stream << *dynamic_cast<sure::payload::NormalPayload*>(payload);
-    }
-    if( dynamic_cast<sure::payload::NormalPayload*>(payload) )
-    {
-      stream << *dynamic_cast<sure::payload::NormalPayload*>(payload);
-    }
-    if( dynamic_cast<sure::payload::EntropyPayload*>(payload) )
-    {
-      stream << *dynamic_cast<sure::payload::EntropyPayload*>(payload);
-    }
-  }
-  else
-  {
-    stream << "No optional payload.\n";
-  }
   stream.unsetf(std::ios_base::fixed);
   return stream;
 }
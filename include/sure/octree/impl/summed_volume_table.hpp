@@ -0,0 +1,174 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+template <typename FixedPayloadT>
+bool sure::octree::SummedVolumeTable<FixedPayloadT>::build(const NodeVector& nodes, const Point& origin, unsigned unitSize, std::size_t maxCells)
+{
+  built_ = true;
+  valid_ = false;
+  unitSize_ = unitSize;
+  origin_ = origin;
+  size_[0] = size_[1] = size_[2] = 0;
+
+  if( nodes.empty() || unitSize == 0 )
+  {
+    valid_ = true;
+    return valid_;
+  }
+
+  // bounding box of the nodes in cells
+  Point lo(nodes[0]->region().min()), hi(nodes[0]->region().min());
+  for(unsigned i=1; i<nodes.size(); ++i)
+  {
+    const Point p(nodes[i]->region().min());
+    for(int axis=0; axis<3; ++axis)
+    {
+      lo[axis] = std::min(lo[axis], p[axis]);
+      hi[axis] = std::max(hi[axis], p[axis]);
+    }
+  }
+  for(int axis=0; axis<3; ++axis)
+  {
+    size_[axis] = (hi[axis] - lo[axis]) / (int) unitSize + 1;
+  }
+  if( cells() > maxCells )
+  {
+    size_[0] = size_[1] = size_[2] = 0;
+    return valid_;
+  }
+  origin_ = lo;
+
+  const std::size_t entries = (std::size_t) (size_[0]+1) * (size_[1]+1) * (size_[2]+1);
+  sums_.assign(entries, FixedPayloadT());
+  counts_.assign(entries, 0);
+
+  for(unsigned i=0; i<nodes.size(); ++i)
+  {
+    const Point c((nodes[i]->region().min() - origin_) / (int) unitSize);
+    const std::size_t idx = index(c[0]+1, c[1]+1, c[2]+1);
+    sums_[idx] += nodes[i]->fixed();
+    counts_[idx]++;
+  }
+
+  // prefix sums along x, y and z
+  const std::size_t strideY = size_[0]+1;
+  const std::size_t strideZ = strideY * (size_[1]+1);
+  for(unsigned z=1; z<=size_[2]; ++z)
+  {
+    for(unsigned y=1; y<=size_[1]; ++y)
+    {
+      for(unsigned x=1; x<=size_[0]; ++x)
+      {
+        const std::size_t idx = index(x, y, z);
+        sums_[idx] += sums_[idx-1];
+        counts_[idx] += counts_[idx-1];
+      }
+    }
+  }
+  for(unsigned z=1; z<=size_[2]; ++z)
+  {
+    for(unsigned y=1; y<=size_[1]; ++y)
+    {
+      for(unsigned x=1; x<=size_[0]; ++x)
+      {
+        const std::size_t idx = index(x, y, z);
+        sums_[idx] += sums_[idx-strideY];
+        counts_[idx] += counts_[idx-strideY];
+      }
+    }
+  }
+  for(unsigned z=1; z<=size_[2]; ++z)
+  {
+    for(unsigned y=1; y<=size_[1]; ++y)
+    {
+      for(unsigned x=1; x<=size_[0]; ++x)
+      {
+        const std::size_t idx = index(x, y, z);
+        sums_[idx] += sums_[idx-strideZ];
+        counts_[idx] += counts_[idx-strideZ];
+      }
+    }
+  }
+
+  valid_ = true;
+  return valid_;
+}
+
+template <typename FixedPayloadT>
+void sure::octree::SummedVolumeTable<FixedPayloadT>::release()
+{
+  PayloadVector().swap(sums_);
+  std::vector<unsigned>().swap(counts_);
+  size_[0] = size_[1] = size_[2] = 0;
+  built_ = valid_ = false;
+}
+
+template <typename FixedPayloadT>
+unsigned sure::octree::SummedVolumeTable<FixedPayloadT>::integrate(const Region& r, FixedPayloadT& payload) const
+{
+  if( !valid_ || cells() == 0 )
+  {
+    return 0;
+  }
+
+  // cells overlapping the region, clamped to the bounding box. Prefix sums are addressed from lo to hi+1
+  unsigned lo[3], hi[3];
+  for(int axis=0; axis<3; ++axis)
+  {
+    int first = cell(r.min()[axis], origin_[axis]);
+    int last = cell(r.max()[axis]-1, origin_[axis]);
+    first = std::max(first, 0);
+    last = std::min(last, (int) size_[axis]-1);
+    if( first > last )
+    {
+      return 0;
+    }
+    lo[axis] = first;
+    hi[axis] = last+1;
+  }
+
+  // inclusion-exclusion over the eight corners, additions first, so unsigned counts never underflow
+  payload += sums_[index(hi[0], hi[1], hi[2])];
+  payload += sums_[index(hi[0], lo[1], lo[2])];
+  payload += sums_[index(lo[0], hi[1], lo[2])];
+  payload += sums_[index(lo[0], lo[1], hi[2])];
+  payload -= sums_[index(lo[0], hi[1], hi[2])];
+  payload -= sums_[index(hi[0], lo[1], hi[2])];
+  payload -= sums_[index(hi[0], hi[1], lo[2])];
+  payload -= sums_[index(lo[0], lo[1], lo[2])];
+
+  unsigned count = counts_[index(hi[0], hi[1], hi[2])] + counts_[index(hi[0], lo[1], lo[2])] + counts_[index(lo[0], hi[1], lo[2])] + counts_[index(lo[0], lo[1], hi[2])];
+  count -= counts_[index(lo[0], hi[1], hi[2])] + counts_[index(hi[0], lo[1], hi[2])] + counts_[index(hi[0], hi[1], lo[2])] + counts_[index(lo[0], lo[1], lo[2])];
+  return count;
+}
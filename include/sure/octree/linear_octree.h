@@ -0,0 +1,335 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_LINEAR_OCTREE_H_
+#define SURE_LINEAR_OCTREE_H_
+
+#include <vector>
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <cmath>
+#include <climits>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+#include <sure/data/typedef.h>
+#include <sure/access/region.h>
+#include <sure/data/range_image.h>
+#include <sure/octree/morton.h>
+
+#include <sure/payload/payload_xyzrgb.h>
+#include <sure/payload/payload_moments.h>
+
+namespace sure
+{
+  namespace octree
+  {
+
+    typedef sure::access::Point Point;
+    typedef sure::access::Region Region;
+    typedef sure::OctantType OctantType;
+
+    /**
+     * Pointerless octree. Every depth is stored as an array of morton keys in ascending order with parallel payload
+     * and child offset arrays, so nodes are addressed by their depth and their index within that depth.
+     * Regions are derived from key and depth, the children of a node are a contiguous range in the next deeper level.
+     * Sweeps over a single depth are linear in memory, the node order is the morton order (and not the insertion order
+     * as in sure::octree::Octree).
+     *
+     * The addressing (octree center, root region, maximum depth) is identical to sure::octree::Octree.
+     */
+    template <typename FixedPayloadT>
+    class LinearOctree
+    {
+      public:
+
+        typedef std::vector<MortonKey> KeyVector;
+        typedef std::vector<unsigned> IndexVector;
+        typedef std::vector<FixedPayloadT, Eigen::aligned_allocator<FixedPayloadT> > PayloadVector;
+
+        //! Returned by lookups, if no node exists
+        static const unsigned INVALID_INDEX = UINT_MAX;
+
+        /**
+         * All nodes of a single depth
+         */
+        struct Level
+        {
+            KeyVector keys;
+            IndexVector children;   //!< Index of the first child in the next deeper level, with one element past the end. Empty in the deepest level
+            PayloadVector payload;
+        };
+
+        LinearOctree() : maxDepth_(0), minimumNodeSize_(DEFAULT_MINIMUM_NODE_SIZE), maxNodeResolution_(DEFAULT_MINIMUM_NODE_SIZE/(Scalar) DEFAULT_MIN_NODE_UNIT_SIZE), octreeCenter_(Vector3::Zero()), initialized_(false), threads_(0)
+        {
+
+        }
+
+        ~LinearOctree() { }
+
+        void clear();
+
+        bool initialize(Scalar minNodeSize, Scalar expansion, const Vector3& center);
+
+        /**
+         * Adds a pointcloud to the octree. Adding to a non-empty octree merges the leaves and rebuilds all higher depths.
+         * @param cloud
+         */
+        template <typename PointT>
+        void addPointCloud(const pcl::PointCloud<PointT>& cloud) { insertPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, NORMAL); }
+
+        /**
+         * Adds a pointcloud to the octree incorporating depth border information
+         * @param cloud
+         * @param rangeImage Provides depth border information
+         */
+        template <typename PointT>
+        void addPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>& rangeImage) { insertPointCloud(cloud, &rangeImage, NORMAL); }
+
+        /**
+         * Adds a pointcloud to the octree flagged as artificial points
+         * @param cloud
+         */
+        template <typename PointT>
+        void addArtificialPointCloud(const pcl::PointCloud<PointT>& cloud) { insertPointCloud(cloud, (const sure::range_image::RangeImage<PointT>*) NULL, ARTIFICIAL); }
+
+        //! True, if the last initialization succeeded
+        bool isInitialized() const { return initialized_; }
+
+        //! Number of worker threads for the insertion, zero selects all available threads
+        void setNumberOfThreads(int threads) { threads_ = threads; }
+        int getNumberOfThreads() const { return threads_; }
+
+        //! Maximum octree depth
+        unsigned getMaximumDepth() const { return maxDepth_; }
+
+        //! Edge length of the smallest leaf
+        float getMinimumNodeSize() const { return minimumNodeSize_; }
+
+        //! Center of the octree
+        const Vector3& getCenter() const { return octreeCenter_; }
+
+        //! Number of nodes in a given depth
+        unsigned size(unsigned depth) const { return levels_[depth].keys.size(); }
+
+        /**
+         * Returns all nodes in a given depth. Does not check bounds
+         */
+        const Level& operator[](unsigned depth) const { return levels_[depth]; }
+
+        //! Morton key of a node, the key of a node in depth d has 3*d significant bits
+        MortonKey key(unsigned depth, unsigned index) const { return levels_[depth].keys[index]; }
+
+        //! Access to the fixed payload of a node
+        const FixedPayloadT& fixed(unsigned depth, unsigned index) const { return levels_[depth].payload[index]; }
+        FixedPayloadT& fixed(unsigned depth, unsigned index) { return levels_[depth].payload[index]; }
+
+        //! Returns the region covered by a node
+        Region region(unsigned depth, unsigned index) const { return getRegion(levels_[depth].keys[index], depth); }
+
+        //! Returns the center of a node's region
+        Point center(unsigned depth, unsigned index) const { return region(depth, index).center(); }
+
+        //! Returns the range [first, last) of the children of a node in depth+1
+        void getChildren(unsigned depth, unsigned index, unsigned& first, unsigned& last) const
+        {
+          if( depth < maxDepth_ )
+          {
+            first = levels_[depth].children[index];
+            last = levels_[depth].children[index+1];
+          }
+          else
+          {
+            first = last = 0;
+          }
+        }
+
+        /**
+         * Returns the index of the child of a node in a given octant (as in Region::getOctant) or INVALID_INDEX
+         */
+        unsigned getChild(unsigned depth, unsigned index, OctantType octant) const;
+
+        /**
+         * Returns the index of the parent (in depth-1) of a node. Does not work for depth == 0.
+         */
+        unsigned getParent(unsigned depth, unsigned index) const { return findKey(depth-1, levels_[depth].keys[index] >> 3); }
+
+        /**
+         * Returns the index of the node which contains the given Address on a given depth. If depth is zero, the maximum depth will be assumed.
+         * If no node contains the Address, INVALID_INDEX will be returned.
+         */
+        unsigned getNode(const Vector3& p, unsigned depth = 0) const { return getNode(getAddress(p), depth); }
+        unsigned getNode(const Point& a, unsigned depth = 0) const;
+
+        /**
+         * Returns the indices of all nodes in a given depth which overlap with a specified area, in morton order.
+         */
+        IndexVector getNodes(const Vector3& point, Scalar radius, Scalar samplingrate) const
+        {
+          return getNodes(Region(getAddress(point), getUnitSize(radius)), getDepth(samplingrate));
+        }
+        IndexVector getNodes(const Point& a, unsigned radius, unsigned depth) const
+        {
+          return getNodes(Region(a-radius, a+radius), depth);
+        }
+        IndexVector getNodes(const Region& r, unsigned depth) const;
+
+        /**
+         * Integrates the fixed payload in a given area. Like sure::octree::Octree, nodes fully contained in the area are
+         * integrated as a whole, otherwise leaves overlapping the area are integrated.
+         */
+        unsigned integratePayload(const Vector3& point, Scalar radius, FixedPayloadT& payload) const
+        {
+          return integratePayload(Region(getAddress(point), getUnitSize(radius)), payload);
+        }
+        unsigned integratePayload(const Point& a, unsigned radius, FixedPayloadT& payload) const { return integratePayload(Region (a-radius, a+radius), payload); }
+        unsigned integratePayload(const Region& r, FixedPayloadT& payload) const;
+
+        /**
+         * Returns the region of a node with a given key in a given depth
+         */
+        Region getRegion(MortonKey key, unsigned depth) const
+        {
+          unsigned x, y, z;
+          decodeMortonKey(key, x, y, z);
+          const int size = getUnitSizeFromDepth(depth);
+          Point min(rootMin_.x() + (int) x * size, rootMin_.y() + (int) y * size, rootMin_.z() + (int) z * size);
+          return Region(min, Point(min.x() + size, min.y() + size, min.z() + size));
+        }
+
+        /**
+         * Returns the key of the node containing the address a in a given depth. Addresses outside of the octree are clamped
+         * to the border nodes.
+         */
+        MortonKey getMortonKey(const Point& a, unsigned depth) const
+        {
+          const int cells = 1 << maxDepth_;
+          MortonKey key = encodeMortonKey(getCellIndex(a.x() - rootMin_.x(), cells), getCellIndex(a.y() - rootMin_.y(), cells), getCellIndex(a.z() - rootMin_.z(), cells));
+          return key >> (3 * (maxDepth_ - depth));
+        }
+
+        /**
+         * Returns the octree address next to a given position
+         */
+        Point getAddress(const Vector3& p) const
+        {
+          Vector3 pos = (p + octreeCenter_) / maxNodeResolution_;
+          return (Point(floor(pos[0]), floor(pos[1]), floor(pos[2])) );
+        }
+        Point getAddress(float x, float y, float z) const
+        {
+          return (Point(floor( (x + octreeCenter_[0]) / maxNodeResolution_ ),
+                          floor( (y + octreeCenter_[1]) / maxNodeResolution_ ),
+                          floor( (z + octreeCenter_[2]) / maxNodeResolution_ )) );
+        }
+
+        //! Returns the size of an octree region in units in a given depth
+        unsigned getUnitSizeFromDepth(unsigned depth) const { return (DEFAULT_MIN_NODE_UNIT_SIZE << (maxDepth_-depth)); }
+
+        //! Returns the unit size to a given size in meters
+        unsigned getUnitSize(Scalar size) const
+        {
+          unsigned units = floor((size / minimumNodeSize_) + 0.5f);
+          return (units * DEFAULT_MIN_NODE_UNIT_SIZE);
+        }
+
+        //! Returns the size in meters of an octree node in a given depth
+        Scalar getSizeFromDepth(unsigned depth) const { return ((Scalar) getUnitSizeFromDepth(depth) * maxNodeResolution_); }
+
+        //! Returns the depth corresponding to a given edge length of the nodes
+        unsigned getDepth(Scalar size) const
+        {
+          unsigned depth = floor(size / minimumNodeSize_);
+          unsigned log(0);
+          while( depth >>= 1 )
+          {
+            log++;
+          }
+          return std::min(maxDepth_-log, maxDepth_);
+        }
+
+      protected:
+
+        /**
+         * Sorts the points of a cloud into leaves and merges them into the octree
+         */
+        template <typename PointT>
+        void insertPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag);
+
+        /**
+         * Merges sorted leaves into the deepest level and rebuilds all higher levels
+         */
+        void mergeLeaves(KeyVector& keys, PayloadVector& payload);
+
+        //! Binary search for a key in a given depth, returns INVALID_INDEX if the key does not exist
+        unsigned findKey(unsigned depth, MortonKey key) const
+        {
+          const KeyVector& keys = levels_[depth].keys;
+          typename KeyVector::const_iterator it = std::lower_bound(keys.begin(), keys.end(), key);
+          if( it == keys.end() || *it != key )
+          {
+            return INVALID_INDEX;
+          }
+          return it - keys.begin();
+        }
+
+        static unsigned getCellIndex(int offset, int cells)
+        {
+          int index = offset < 0 ? 0 : offset / (int) DEFAULT_MIN_NODE_UNIT_SIZE;
+          return (unsigned) std::min(index, cells-1);
+        }
+
+        std::vector<Level> levels_;
+
+        unsigned maxDepth_;
+        Scalar minimumNodeSize_, maxNodeResolution_;
+        Vector3 octreeCenter_;
+        Region rootRegion_;
+        Point rootMin_;
+        bool initialized_;
+        int threads_;
+
+      private:
+
+        LinearOctree(const LinearOctree& rhs) { }
+
+    };
+  }
+}
+
+#include <sure/octree/impl/linear_octree.hpp>
+
+#endif /* SURE_LINEAR_OCTREE_H_ */
@@ -0,0 +1,140 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_MORTON_H_
+#define SURE_MORTON_H_
+
+#include <vector>
+#include <stdint.h>
+
+#include <sure/data/typedef.h>
+
+namespace sure
+{
+  namespace octree
+  {
+
+    /**
+     * Morton code (z-order) of a leaf cell. Three bits per depth, the bits for the root level are the most significant ones.
+     * Per level, the x-bit is the highest and the z-bit the lowest bit.
+     */
+    typedef uint64_t MortonKey;
+
+    //! Maximum depth which can be represented by a 64 bit morton key (including one bit for marking invalid keys)
+    const unsigned MAX_MORTON_DEPTH = 21;
+
+    /**
+     * Spreads the lower 21 bits of v, so that there are two zero bits between each of them
+     */
+    inline MortonKey spreadBits(MortonKey v)
+    {
+      v &= 0x1fffffULL;
+      v = (v | (v << 32)) & 0x1f00000000ffffULL;
+      v = (v | (v << 16)) & 0x1f0000ff0000ffULL;
+      v = (v | (v << 8))  & 0x100f00f00f00f00fULL;
+      v = (v | (v << 4))  & 0x10c30c30c30c30c3ULL;
+      v = (v | (v << 2))  & 0x1249249249249249ULL;
+      return v;
+    }
+
+    /**
+     * Inverse of spreadBits
+     */
+    inline unsigned compactBits(MortonKey v)
+    {
+      v &= 0x1249249249249249ULL;
+      v = (v | (v >> 2))  & 0x10c30c30c30c30c3ULL;
+      v = (v | (v >> 4))  & 0x100f00f00f00f00fULL;
+      v = (v | (v >> 8))  & 0x1f0000ff0000ffULL;
+      v = (v | (v >> 16)) & 0x1f00000000ffffULL;
+      v = (v | (v >> 32)) & 0x1fffffULL;
+      return (unsigned) v;
+    }
+
+    //! Interleaves the cell indices of a leaf to its morton key
+    inline MortonKey encodeMortonKey(unsigned x, unsigned y, unsigned z)
+    {
+      return (spreadBits(x) << 2) | (spreadBits(y) << 1) | spreadBits(z);
+    }
+
+    //! Splits a morton key into the cell indices of the leaf
+    inline void decodeMortonKey(MortonKey key, unsigned& x, unsigned& y, unsigned& z)
+    {
+      x = compactBits(key >> 2);
+      y = compactBits(key >> 1);
+      z = compactBits(key);
+    }
+
+    /**
+     * Returns the octant id (as used by Region::getOctant) of the child, which is addressed by the lowest three bits of a key.
+     * Region sets an octant bit for the lower half of a dimension, the morton key for the upper half, so the bits are inverted.
+     */
+    inline OctantType getMortonOctant(MortonKey key)
+    {
+      return (OctantType) (~key & (MortonKey) 7);
+    }
+
+    /**
+     * Pairs a morton key with the index of the point it was calculated from
+     */
+    struct MortonIndex
+    {
+        MortonKey key;
+        unsigned index;
+    };
+
+    /**
+     * Sorts a list of morton keys in ascending order with a parallel least significant digit radix sort.
+     * The sort is stable, so points within the same leaf keep their original order.
+     * @param data List to be sorted
+     * @param buffer Scratch space, will be resized to the size of data
+     * @param keyBits Number of significant bits in the keys
+     * @param threads Number of worker threads, zero selects all available threads
+     */
+    void sortMortonIndices(std::vector<MortonIndex>& data, std::vector<MortonIndex>& buffer, unsigned keyBits, int threads = 0);
+
+    /**
+     * Sorts points along their morton keys and groups them into leaves. Points with invalidKey are sorted to the end and skipped.
+     * @param points Keys and indices of the points, will be sorted
+     * @param invalidKey Key marking invalid points, needs to be greater than all valid keys
+     * @param leafKeys Receives the key of every leaf
+     * @param leafBegin Receives the position of the first point of every leaf in points, with one element past the end
+     * @param threads Number of worker threads for sorting, zero selects all available threads
+     */
+    void groupMortonIndices(std::vector<MortonIndex>& points, MortonKey invalidKey, std::vector<MortonKey>& leafKeys, std::vector<unsigned>& leafBegin, int threads = 0);
+
+  }
+}
+
+#endif /* SURE_MORTON_H_ */
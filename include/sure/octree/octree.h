@@ -37,9 +37,17 @@
 #include <vector>
 #include <map>
 #include <deque>
+#include <algorithm>
 #include <iomanip>
 #include <cmath>
 #include <climits>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include <pcl/point_types.h>
 #include <pcl/point_cloud.h>
@@ -48,9 +56,13 @@
 #include <sure/access/region.h>
 #include <sure/data/range_image.h>
 #include <sure/octree/octree_node.h>
+#include <sure/octree/morton.h>
+#include <sure/octree/summed_volume_table.h>
 #include <sure/memory/fixed_size_allocator.h>
+#include <sure/memory/chunked_allocator.h>
 
 #include <sure/payload/payload_xyzrgb.h>
+#include <sure/payload/payload_moments.h>
 
 namespace sure
 {
@@ -71,6 +83,8 @@ namespace sure
      * Octree data structure
      * Its internal addressing is integerbased
      * During the building, each node will be added to a list corresponding to its depth
+     * The FixedPayloadT must implement the += operator, setPosition(x, y, z), setColor(float rgb) and setFlag(PointFlag),
+     * summed-volume tables additionally need the -= operator
      */
     template <typename FixedPayloadT>
     class Octree
@@ -78,11 +92,14 @@ namespace sure
       public:
 
         typedef sure::octree::Node<FixedPayloadT> Node;
-        typedef sure::memory::FixedSizeAllocator<Node> Allocator;
+        //! Node pool, sure::memory::FixedSizeAllocator<Node> can be used as a replacement with a fixed capacity
+        typedef sure::memory::ChunkedAllocator<Node> Allocator;
         typedef std::vector<Node* > NodeVector;
         typedef std::map<unsigned, NodeVector> LevelMap;
+        typedef sure::octree::SummedVolumeTable<FixedPayloadT> VolumeTable;
+        typedef std::map<unsigned, VolumeTable> VolumeTableMap;
 
-        Octree() : root_(NULL), allocator_(), maxDepth_(0), minimumNodeSize_(DEFAULT_MINIMUM_NODE_SIZE), maxNodeResolution_(DEFAULT_MINIMUM_NODE_SIZE/(Scalar) DEFAULT_MIN_NODE_UNIT_SIZE), octreeCenter_(Vector3::Zero()), initialized_(false)
+        Octree() : root_(NULL), allocator_(), maxDepth_(0), minimumNodeSize_(DEFAULT_MINIMUM_NODE_SIZE), maxNodeResolution_(DEFAULT_MINIMUM_NODE_SIZE/(Scalar) DEFAULT_MIN_NODE_UNIT_SIZE), octreeCenter_(Vector3::Zero()), initialized_(false), constructionMode_(INCREMENTAL_INSERTION), reuseMemory_(false), threads_(0), tableLimit_(0)
         {
 
         }
@@ -91,8 +108,36 @@ namespace sure
 
         void clear();
 
+        /**
+         * Initializes an empty octree. The node pool reserves capacity nodes and grows on demand.
+         * If memory reuse is enabled, the node pool of the last initialization is kept and only grows, if capacity exceeds it.
+         * Otherwise the pool is reallocated.
+         */
         bool initialize(Scalar minNodeSize, Scalar expansion, unsigned capacity, const Vector3& center);
 
+        /**
+         * Enables keeping the node pool and the level lists between initializations, e.g. for processing a sensor stream
+         */
+        void setReuseMemory(bool reuse) { reuseMemory_ = reuse; }
+        bool getReuseMemory() const { return reuseMemory_; }
+
+        /**
+         * Enables summed-volume tables for integrating the fixed payload. After the construction, the table of a depth is
+         * built lazily by the first integration query in that depth, if the bounding box of the depth has at most
+         * maxCells cells. Otherwise queries traverse the tree. Zero disables the tables.
+         * NOTE: Integrating with a table sums the payload of all overlapping nodes in that depth in constant time,
+         * but the point flag of the result is meaningless.
+         */
+        void setSummedVolumeTableLimit(std::size_t maxCells) { tableLimit_ = maxCells; invalidateSummedVolumeTables(); }
+        std::size_t getSummedVolumeTableLimit() const { return tableLimit_; }
+
+        /**
+         * Returns the summed-volume table of a depth and builds it, if necessary. Returns NULL, if tables are disabled
+         * or the depth exceeds the limit. Thread-safe: a missing table is built under a lock, later queries read it without
+         * locking. Parallel stages still request the table beforehand, so no thread waits for the build.
+         */
+        const VolumeTable* getSummedVolumeTable(unsigned depth) const;
+
         /**
          * Adds a pointcloud to the octree
          * @param cloud
@@ -115,6 +160,23 @@ namespace sure
         template <typename PointT>
         void addArtificialPointCloud(const pcl::PointCloud<PointT>& cloud);
 
+        /**
+         * Sets how point clouds are inserted. All modes result in the same tree and the same node order in the level map.
+         * MORTON_SORTED_INSERTION needs memory for two morton keys per point and for the nodes of one point cloud while building.
+         * CONCURRENT_INSERTION needs memory for the payload of every visited node per thread and takes nodes from the pool
+         * in slabs, so up to NODE_SLAB_SIZE unused nodes per thread remain in the pool. The sums of the moments are merged
+         * in thread order and may differ in the last bits for different numbers of threads.
+         */
+        void setConstructionMode(OctreeConstructionMode mode) { constructionMode_ = mode; }
+        OctreeConstructionMode getConstructionMode() const { return constructionMode_; }
+
+        /**
+         * Number of threads used by MORTON_SORTED_INSERTION and CONCURRENT_INSERTION, including the radix sort of the
+         * sorted insertion. INCREMENTAL_INSERTION is serial. Zero or less selects all available threads.
+         */
+        void setNumberOfThreads(int threads) { threads_ = threads; }
+        int getNumberOfThreads() const { return threads_; }
+
         //! Maximum octree depth
         unsigned getMaximumDepth() const { return maxDepth_; }
 
@@ -124,6 +186,9 @@ namespace sure
         //! Center of the octree
         const Vector3& getCenter() const { return octreeCenter_; }
 
+        //! Node pool, e.g. for its statistics
+        const Allocator& getAllocator() const { return allocator_; }
+
         /**
          * Return the list of nodes at a given depth. Throws out_of_range, if depth exceeds max depth
          * @param depth
@@ -154,6 +219,50 @@ namespace sure
         const NodeVector& operator[](unsigned depth) const { return map_[depth]; }
         NodeVector& operator[](unsigned depth) { return map_[depth]; }
 
+        //! Returns the number of nodes at a given depth, zero for depths without nodes
+        std::size_t getNumberOfNodes(unsigned depth) const
+        {
+          typename LevelMap::const_iterator it = map_.find(depth);
+          return it != map_.end() ? it->second.size() : 0;
+        }
+
+        /**
+         * Calls f(node) for all nodes in a given depth which overlap with a specified area. The nodes are visited in
+         * the same order as getNodes returns them. The traversal uses a fixed size stack and does not allocate memory.
+         * The visitor has to provide bool operator()(Node*), returning false stops the traversal.
+         * Returns false, if the traversal was stopped by the visitor. Does not work for depth == 0.
+         */
+        template <typename VisitorT>
+        bool forEachNodeIn(const Point& a, unsigned radius, unsigned depth, VisitorT& f) const
+        {
+          return forEachNodeIn(Region(a-radius, a+radius), depth, f);
+        }
+        template <typename VisitorT>
+        bool forEachNodeIn(const Vector3& point, Scalar radius, Scalar samplingrate, VisitorT& f) const
+        {
+          return forEachNodeIn(Region(getAddress(point), getUnitSize(radius)), getDepth(samplingrate), f);
+        }
+        template <typename VisitorT>
+        bool forEachNodeIn(const Region& r, unsigned depth, VisitorT& f) const;
+
+        /**
+         * Calls f(node) for all neighbor nodes to a given node (in the same depth), see above.
+         */
+        template <typename VisitorT>
+        bool forEachNodeIn(Node* node, unsigned radius, unsigned depth, VisitorT& f) const { return forEachNodeIn(node->center(), radius, depth, f); }
+
+        /**
+         * Calls f(node) for all nodes which are fully included in a specified area and for all leaves overlapping with it.
+         * Like forEachNodeIn, but nodes are visited depth-first.
+         */
+        template <typename VisitorT>
+        bool forEachNodeWithin(const Vector3& point, Scalar radius, VisitorT& f) const
+        {
+          return forEachNodeWithin(Region(getAddress(point), getUnitSize(radius)), f);
+        }
+        template <typename VisitorT>
+        bool forEachNodeWithin(const Region& r, VisitorT& f) const;
+
         /**
          * Returns a vector with all nodes which are fully included in a specified area.
          */
@@ -186,7 +295,8 @@ namespace sure
         NodeVector getNodes(Node* node, unsigned radius) const { return getNodes(node->center(), radius, node->depth()); }
 
         /**
-         * Integrates the fixed payload in a given area.
+         * Integrates the fixed payload in a given area. Uses the summed-volume table of the corresponding depth, if enabled.
+         * Without depth, all leaves overlapping the area are integrated.
          */
         unsigned integratePayload(const Point& a, unsigned radius, FixedPayloadT& payload) const { return integratePayload(Region (a-radius, a+radius), payload); }
         unsigned integratePayload(const Vector3& point, Scalar radius, FixedPayloadT& payload) const
@@ -202,28 +312,22 @@ namespace sure
         unsigned integratePayload(const Region& r, unsigned depth, FixedPayloadT& payload) const;
 
         /**
-         * Integrates the optional payload in a given area.
-         * NOTE: The optional payload type needs to have an operator+= defined.
-         * NOTE: static_cast is used for typecasting the pointer
+         * Integrates the values of a side table in a given area. The table stores one value per node of the given depth,
+         * addressed by Node::index(), e.g. the histograms of a sure::payload::NormalTable.
+         * NOTE: The value type needs to have an operator+= defined.
          */
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Point& a, unsigned radius, OptionalPayloadT& payload) const { return integrateOptionalPayload<OptionalPayloadT>(Region (a-radius, a+radius), payload); }
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Vector3& point, Scalar radius, OptionalPayloadT& payload) const
+        template <typename ValueT, typename AllocatorT>
+        unsigned integrateSideTable(const Point& a, unsigned radius, unsigned depth, const std::vector<ValueT, AllocatorT>& values, ValueT& sum) const
         {
-          return integrateOptionalPayload(Region(getAddress(point), getUnitSize(radius)), payload);
+          return integrateSideTable(Region (a-radius, a+radius), depth, values, sum);
         }
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Point& a, unsigned radius, unsigned depth, OptionalPayloadT& payload) const{ return integrateOptionalPayload<OptionalPayloadT>(Region (a-radius, a+radius), depth, payload); }
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Vector3& point, Scalar radius, Scalar samplingrate, OptionalPayloadT& payload) const
+        template <typename ValueT, typename AllocatorT>
+        unsigned integrateSideTable(const Vector3& point, Scalar radius, Scalar samplingrate, const std::vector<ValueT, AllocatorT>& values, ValueT& sum) const
         {
-          return integrateOptionalPayload(Region(getAddress(point), getUnitSize(radius)), getDepth(samplingrate), payload);
+          return integrateSideTable(Region(getAddress(point), getUnitSize(radius)), getDepth(samplingrate), values, sum);
         }
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Region& r, OptionalPayloadT& payload) const;
-        template <typename OptionalPayloadT>
-        unsigned integrateOptionalPayload(const Region& r, unsigned depth, OptionalPayloadT& payload) const;
+        template <typename ValueT, typename AllocatorT>
+        unsigned integrateSideTable(const Region& r, unsigned depth, const std::vector<ValueT, AllocatorT>& values, ValueT& sum) const;
 
         /**
          * Returns a pointer to the node which contains the given Address on a given depth. If depth ist not set or zero, the maximum depth will be assumed.
@@ -259,6 +363,17 @@ namespace sure
                           floor( (z + octreeCenter_[2]) / maxNodeResolution_ )) );
         }
 
+        /**
+         * Returns the morton key of the leaf containing the address a. Addresses outside of the octree are clamped
+         * to the border leaves, just like insertNode does.
+         */
+        MortonKey getMortonKey(const Point& a) const
+        {
+          const Point min(root_->region().min());
+          const int cells = 1 << maxDepth_;
+          return encodeMortonKey(getCellIndex(a.x() - min.x(), cells), getCellIndex(a.y() - min.y(), cells), getCellIndex(a.z() - min.z(), cells));
+        }
+
         /**
          * Returns the octree region next to the position in a given depth
          * @param p
@@ -340,8 +455,136 @@ namespace sure
 
       protected:
 
+        //! Upper bound for the depth of the octree, since node sizes are stored as unsigned units
+        static const unsigned MAX_TRAVERSAL_DEPTH = 32;
+        //! Each traversal step replaces one node on the stack by at most OCTANT children
+        static const unsigned TRAVERSAL_STACK_SIZE = (OCTANT-1) * MAX_TRAVERSAL_DEPTH + 1;
+
+        /**
+         * Visitors used by the range queries
+         */
+        struct NodeCollector
+        {
+            NodeCollector(NodeVector& nodes) : nodes_(nodes) { }
+            bool operator()(Node* node) { nodes_.push_back(node); return true; }
+            NodeVector& nodes_;
+        };
+
+        struct PayloadIntegrator
+        {
+            PayloadIntegrator(FixedPayloadT& payload) : payload_(payload), count_(0) { }
+            bool operator()(Node* node) { payload_ += node->fixed(); count_++; return true; }
+            FixedPayloadT& payload_;
+            unsigned count_;
+        };
+
+        template <typename ValueT, typename AllocatorT>
+        struct SideTableIntegrator
+        {
+            SideTableIntegrator(const std::vector<ValueT, AllocatorT>& values, ValueT& sum) : values_(values), sum_(sum), count_(0) { }
+            bool operator()(Node* node) { sum_ += values_[node->index()]; count_++; return true; }
+            const std::vector<ValueT, AllocatorT>& values_;
+            ValueT& sum_;
+            unsigned count_;
+        };
+
         void insertNode(Node* current, const Node& node, unsigned level);
 
+        typedef std::vector<FixedPayloadT, Eigen::aligned_allocator<FixedPayloadT> > PayloadVector;
+
+        /**
+         * Nodes of a single depth built from a sorted point cloud. The nodes are ordered by their morton keys.
+         */
+        struct SortedLevel
+        {
+            std::vector<MortonKey> keys;
+            std::vector<unsigned> first;    //!< Smallest point index in the node
+            std::vector<unsigned> begin;    //!< Index of the first child (or sorted point for leaves), with one element past the end
+            std::vector<unsigned> parent;   //!< Index of the parent node in the next higher level
+            NodeVector nodes;
+        };
+
+        /**
+         * Inserts a point cloud by sorting the points along their morton keys and building the tree bottom-up.
+         * @param rangeImage Provides depth border information, may be NULL
+         * @param flag Flag for points without border information
+         */
+        template <typename PointT>
+        void insertSortedPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag);
+
+        /**
+         * Groups the leaves in levels[maxDepth_] into all higher levels and links the nodes into the tree
+         */
+        void linkSortedLevels(std::vector<SortedLevel>& levels, unsigned numberOfPoints);
+
+        /**
+         * Adds the payload of the leaves to the linked nodes and merges it upwards to the root
+         */
+        void mergeSortedPayload(std::vector<SortedLevel>& levels, PayloadVector& payload);
+
+        //! Number of nodes a thread takes from the node pool at once during concurrent insertion
+        static const unsigned NODE_SLAB_SIZE = 256;
+
+        /**
+         * Payload accumulated by a single thread during concurrent insertion. An open addressing hash table maps every
+         * node visited by the thread to its entry.
+         */
+        struct ThreadPayload
+        {
+            std::vector<int> table;
+            NodeVector nodes;
+            PayloadVector sums;
+            std::vector<unsigned> first;      //!< Smallest point index of the thread in the node
+            std::vector<NodeVector> created;  //!< Nodes created by the thread per depth
+            Node* slab;
+            unsigned slabSize;
+
+            ThreadPayload() : slab(NULL), slabSize(0) { }
+
+            void clear(unsigned depths);
+            unsigned getEntry(Node* node, unsigned pointIndex);
+            int find(Node* node) const;
+            void rehash(std::size_t tableSize);
+
+            static std::size_t hash(const Node* node) { return (std::size_t) node / sizeof(Node) * 2654435761u; }
+        };
+
+        /**
+         * Inserts a point cloud with several threads. Every thread inserts a contiguous block of points, creates missing
+         * nodes with compare-and-swap and accumulates the payload in its own table. Afterwards the tables are merged
+         * in thread order and the new nodes are appended to the level map in the order of their first point.
+         * If a thread throws, e.g. a bad_alloc of the node pool, all threads stop and the exception is rethrown after the
+         * parallel region. The octree is incomplete then.
+         * @param rangeImage Provides depth border information, may be NULL
+         * @param flag Flag for points without border information
+         */
+        template <typename PointT>
+        void insertConcurrentPointCloud(const pcl::PointCloud<PointT>& cloud, const sure::range_image::RangeImage<PointT>* rangeImage, PointFlag flag);
+
+        //! Returns the child of current in the given octant and creates it with compare-and-swap, if necessary
+        Node* getOrCreateChild(Node* current, OctantType octant, unsigned depth, ThreadPayload& local);
+
+        //! Marks all summed-volume tables for rebuilding, e.g. after inserting points
+        void invalidateSummedVolumeTables();
+
+        //! True, if point clouds are inserted with insertSortedPointCloud
+        bool useSortedInsertion() const
+        {
+          return constructionMode_ == MORTON_SORTED_INSERTION && maxDepth_ > 0 && maxDepth_ <= MAX_MORTON_DEPTH;
+        }
+
+        //! True, if point clouds are inserted with insertConcurrentPointCloud
+        bool useConcurrentInsertion() const
+        {
+          return constructionMode_ == CONCURRENT_INSERTION && maxDepth_ > 0;
+        }
+
+        static unsigned getCellIndex(int offset, int cells)
+        {
+          int index = offset < 0 ? 0 : offset / (int) DEFAULT_MIN_NODE_UNIT_SIZE;
+          return (unsigned) std::min(index, cells-1);
+        }
+
         unsigned intlog2(unsigned val) const
         {
           unsigned ret(0);
@@ -364,6 +607,15 @@ namespace sure
         Vector3 octreeCenter_;
         bool initialized_;
 
+        OctreeConstructionMode constructionMode_;
+        bool reuseMemory_;
+        int threads_;
+        std::vector<ThreadPayload> threadPayload_;
+
+        mutable VolumeTableMap tables_;
+        mutable std::vector<const VolumeTable*> builtTables_;
+        std::size_t tableLimit_;
+
       private:
 
         Octree(const Octree& rhs) { }
@@ -37,12 +37,9 @@
 #include <cstring>
 
 #include <sure/access/region.h>
-#include <sure/payload/payload.h>
 
 #include <sure/payload/payload_xyzrgb.h>
-#include <sure/payload/payload_normal.h>
-#include <sure/payload/payload_cross_product.h>
-#include <sure/payload/payload_entropy.h>
+#include <sure/payload/payload_moments.h>
 
 namespace sure
 {
@@ -53,7 +50,6 @@ namespace sure
     typedef sure::access::Point Point;
     typedef sure::access::Region Region;
     typedef sure::OctantType OctantType;
-    typedef sure::payload::Payload OptionalPayload;
 
     template <typename FixedPayloadT>
     class Octree;
@@ -66,24 +62,26 @@ namespace sure
     /**
      * Octree node
      * The FixedPayloadT must implement the += operator
+     * Optional data of the calculation stages is stored in side tables per depth, e.g. sure::payload::NormalTable,
+     * which are addressed by the index of the node in its depth.
      */
     template <typename FixedPayloadT>
     class Node
     {
       public:
 
-        Node() : region_(), fixed_(), opt_(NULL), parent_(NULL)
+        Node() : region_(), fixed_(), index_(0), parent_(NULL)
         {
           clearChildren();
         }
 
-        Node(const Region& r) : region_(r), fixed_(), opt_(NULL), parent_(NULL)
+        Node(const Region& r) : region_(r), fixed_(), index_(0), parent_(NULL)
         {
           clearChildren();
         }
 
         //! Parents or children will NOT be copied
-        Node(const Node& rhs) : region_(rhs.region_), fixed_(rhs.fixed_), opt_(NULL), parent_(NULL)
+        Node(const Node& rhs) : region_(rhs.region_), fixed_(rhs.fixed_), index_(0), parent_(NULL)
         {
           clearChildren();
         }
@@ -122,16 +120,8 @@ namespace sure
         const FixedPayloadT& fixed() const { return fixed_; }
         FixedPayloadT& fixed() { return fixed_; }
 
-        //! Acces to the optional payload
-        OptionalPayload* opt() { return opt_; }
-        const OptionalPayload* opt() const { return opt_; }
-
-        /**
-         * Sets the optional payload. Note: The node never takes ownership of the pointer,
-         * you are required to handle the deletion of the object
-         * @param o
-         */
-        void setOptionalPayload(OptionalPayload* o) { opt_ = o; }
+        //! Index of the node in the level list of its depth, used for addressing side tables
+        unsigned index() const { return index_; }
 
         //! Returns the depth of the node
         unsigned depth() const { return (parent_ ? parent_->depth()+1 : 0); }
@@ -149,7 +139,7 @@ namespace sure
         Region region_;
 
         FixedPayloadT fixed_;
-        OptionalPayload* opt_;
+        unsigned index_;
 
         Node* children_[OCTANT];
         Node* parent_;
@@ -0,0 +1,139 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_SUMMED_VOLUME_TABLE_H_
+#define SURE_SUMMED_VOLUME_TABLE_H_
+
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+
+#include <Eigen/StdVector>
+
+#include <sure/data/typedef.h>
+#include <sure/access/region.h>
+#include <sure/octree/octree_node.h>
+
+namespace sure
+{
+  namespace octree
+  {
+
+    typedef sure::access::Point Point;
+    typedef sure::access::Region Region;
+
+    /**
+     * Summed-volume table (three dimensional prefix sums) over the fixed payload of all nodes in a single octree depth.
+     * The table is dense and covers the bounding box of the nodes, so integrating the payload of all nodes overlapping
+     * a box takes eight lookups, independent of the size of the box.
+     *
+     * The FixedPayloadT must implement the += and -= operators. Point flags can not be subtracted, so the flag of an
+     * integrated payload is meaningless. Sums are taken over the whole bounding box, the precision of the payload type
+     * limits the size of a useful table.
+     */
+    template <typename FixedPayloadT>
+    class SummedVolumeTable
+    {
+      public:
+
+        typedef sure::octree::Node<FixedPayloadT> Node;
+        typedef std::vector<Node* > NodeVector;
+        typedef std::vector<FixedPayloadT, Eigen::aligned_allocator<FixedPayloadT> > PayloadVector;
+
+        SummedVolumeTable() : origin_(), unitSize_(0), built_(false), valid_(false) { size_[0] = size_[1] = size_[2] = 0; }
+
+        /**
+         * Builds the table from all nodes of a depth. The nodes must have the edge length unitSize and be aligned
+         * to origin. Fails and leaves the table invalid, if the bounding box of the nodes exceeds maxCells.
+         * Memory of a former table is reused.
+         */
+        bool build(const NodeVector& nodes, const Point& origin, unsigned unitSize, std::size_t maxCells);
+
+        //! Invalidates the table, but keeps its memory
+        void clear() { built_ = valid_ = false; }
+
+        //! Releases the memory of the table
+        void release();
+
+        //! True, if build was called since the last clear, even if it failed
+        bool built() const { return built_; }
+
+        //! True, if the table can be used for integration
+        bool valid() const { return valid_; }
+
+        /**
+         * Adds the payload of all nodes overlapping with the region r to payload and returns the number of those nodes
+         */
+        unsigned integrate(const Region& r, FixedPayloadT& payload) const;
+
+        //! Number of cells along each axis of the bounding box
+        unsigned size(unsigned axis) const { return size_[axis]; }
+
+        //! Number of cells in the bounding box
+        std::size_t cells() const { return (std::size_t) size_[0] * size_[1] * size_[2]; }
+
+        //! Allocated memory in bytes
+        std::size_t memory() const { return sums_.capacity() * sizeof(FixedPayloadT) + counts_.capacity() * sizeof(unsigned); }
+
+      protected:
+
+        //! Index of the prefix sum up to (excluding) cell x,y,z
+        std::size_t index(unsigned x, unsigned y, unsigned z) const
+        {
+          return ((std::size_t) z * (size_[1]+1) + y) * (size_[0]+1) + x;
+        }
+
+        //! Cell index of a coordinate along an axis, rounded down
+        int cell(int coordinate, int axisOrigin) const
+        {
+          int offset = coordinate - axisOrigin;
+          return (offset >= 0) ? offset / (int) unitSize_ : -((-offset + (int) unitSize_ - 1) / (int) unitSize_);
+        }
+
+        PayloadVector sums_;
+        std::vector<unsigned> counts_;
+
+        Point origin_;        //!< Minimum corner of the bounding box in octree units
+        unsigned unitSize_;   //!< Edge length of a cell in octree units
+        unsigned size_[3];
+        bool built_;
+        bool valid_;
+
+    };
+  }
+}
+
+#include <sure/octree/impl/summed_volume_table.hpp>
+
+#endif /* SURE_SUMMED_VOLUME_TABLE_H_ */
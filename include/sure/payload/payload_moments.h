@@ -0,0 +1,230 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_PAYLOAD_MOMENTS_H_
+#define SURE_PAYLOAD_MOMENTS_H_
+
+#include <ostream>
+#include <iomanip>
+#include <Eigen/Core>
+
+#include <sure/data/typedef.h>
+#include <sure/normal/normal.h>
+
+
+namespace sure
+{
+  namespace payload
+  {
+    typedef sure::PointFlag PointFlag;
+
+    /**
+     * Compact payload for integrating point and color information during octree creation.
+     * Stores the six unique second moments of the points, the mean is calculated on demand.
+     * Positions are summed in double precision, as the covariance is calculated by subtracting
+     * the squared mean from the second moments. Colors are summed in float precision.
+     * Has no virtual methods and takes 88 bytes (PointsRGB: 160 bytes).
+     */
+    class PointMoments
+    {
+      public:
+
+        PointMoments() : points_(0), flag_(NO_FLAG)
+        {
+          pointSum_[0] = pointSum_[1] = pointSum_[2] = 0.0;
+          for(int i=0; i<SECOND_MOMENTS; ++i)
+          {
+            pointSqrSum_[i] = 0.0;
+          }
+          colorSum_[0] = colorSum_[1] = colorSum_[2] = 0.f;
+        }
+
+        PointMoments operator+(const PointMoments& rhs) const
+        {
+          PointMoments r(*this);
+          r += rhs;
+          return r;
+        }
+
+        PointMoments& operator+=(const PointMoments& rhs)
+        {
+          this->points_ += rhs.points_;
+          this->pointSum_[0] += rhs.pointSum_[0];
+          this->pointSum_[1] += rhs.pointSum_[1];
+          this->pointSum_[2] += rhs.pointSum_[2];
+          for(int i=0; i<SECOND_MOMENTS; ++i)
+          {
+            this->pointSqrSum_[i] += rhs.pointSqrSum_[i];
+          }
+          this->colorSum_[0] += rhs.colorSum_[0];
+          this->colorSum_[1] += rhs.colorSum_[1];
+          this->colorSum_[2] += rhs.colorSum_[2];
+          this->flag_ |= rhs.flag_;
+          return *this;
+        }
+
+        /**
+         * Removes the points of rhs, e.g. for summed-volume tables. The point flag is kept, since flags can not be subtracted.
+         */
+        PointMoments& operator-=(const PointMoments& rhs)
+        {
+          this->points_ -= rhs.points_;
+          this->pointSum_[0] -= rhs.pointSum_[0];
+          this->pointSum_[1] -= rhs.pointSum_[1];
+          this->pointSum_[2] -= rhs.pointSum_[2];
+          for(int i=0; i<SECOND_MOMENTS; ++i)
+          {
+            this->pointSqrSum_[i] -= rhs.pointSqrSum_[i];
+          }
+          this->colorSum_[0] -= rhs.colorSum_[0];
+          this->colorSum_[1] -= rhs.colorSum_[1];
+          this->colorSum_[2] -= rhs.colorSum_[2];
+          return *this;
+        }
+
+        void clear()
+        {
+          *this = PointMoments();
+          flag_ = NORMAL;
+        }
+
+        Vector3 getPosSum() const { return Vector3(pointSum_[0], pointSum_[1], pointSum_[2]); }
+        Matrix3 getPosSqrSum() const
+        {
+          Matrix3 m;
+          m << pointSqrSum_[XX], pointSqrSum_[XY], pointSqrSum_[XZ],
+               pointSqrSum_[XY], pointSqrSum_[YY], pointSqrSum_[YZ],
+               pointSqrSum_[XZ], pointSqrSum_[YZ], pointSqrSum_[ZZ];
+          return m;
+        }
+        Vector3 getColorSum() const { return Vector3(colorSum_[0], colorSum_[1], colorSum_[2]); }
+        unsigned getPointCount() const { return points_; }
+        PointFlag getPointFlag() const { return (PointFlag) flag_; }
+
+        Vector3 getMeanPosition() const { return points_ ? Vector3(getPosSum() / (Scalar) points_) : Vector3::Zero(); }
+        Vector3 getMeanColor() const { return getColorSum() / (Scalar) points_; }
+        Scalar red() const { return colorSum_[0] / (Scalar) points_; }
+        Scalar green() const { return colorSum_[1] / (Scalar) points_; }
+        Scalar blue() const { return colorSum_[2] / (Scalar) points_; }
+
+        void setPosition(const Vector3& xyz)
+        {
+          this->setPosition(xyz[0], xyz[1], xyz[2]);
+        }
+        void setPosition(Scalar x, Scalar y, Scalar z)
+        {
+          pointSum_[0] = x;
+          pointSum_[1] = y;
+          pointSum_[2] = z;
+          pointSqrSum_[XX] = x*x;
+          pointSqrSum_[XY] = x*y;
+          pointSqrSum_[XZ] = x*z;
+          pointSqrSum_[YY] = y*y;
+          pointSqrSum_[YZ] = y*z;
+          pointSqrSum_[ZZ] = z*z;
+          points_ = 1;
+        }
+
+        void setColor(const Vector3& rgb)
+        {
+          this->setColor(rgb[0], rgb[1], rgb[2]);
+        }
+        void setColor(Scalar r, Scalar g, Scalar b)
+        {
+          colorSum_[0] = r;
+          colorSum_[1] = g;
+          colorSum_[2] = b;
+        }
+        void setColor(float rgb)
+        {
+          int color = *reinterpret_cast<const int*>(&rgb);
+          float r = float((0xff0000 & color) >> 16) / 255.f;
+          float g = float((0x00ff00 & color) >> 8) / 255.f;
+          float b = float( 0x0000ff & color) / 255.f;
+          this->setColor(r, g, b);
+        }
+
+        /**
+         * Sets the integrated moments directly, e.g. the sums of an integral image
+         * @param points
+         * @param posSum Sum of the positions
+         * @param posSqrSum Sums of the second moments in the order xx, xy, xz, yy, yz, zz
+         */
+        void setMoments(unsigned points, const double* posSum, const double* posSqrSum)
+        {
+          points_ = points;
+          pointSum_[0] = posSum[0];
+          pointSum_[1] = posSum[1];
+          pointSum_[2] = posSum[2];
+          for(int i=0; i<SECOND_MOMENTS; ++i)
+          {
+            pointSqrSum_[i] = posSqrSum[i];
+          }
+        }
+
+        void setFlag(PointFlag flag) { flag_ = flag; }
+
+        bool valid() const
+        {
+          return eigen_is_finite(getColorSum()) && eigen_is_finite(getPosSqrSum()) && eigen_is_finite(getPosSum());
+        }
+
+        /**
+         * Calculates the normal using the integrated point data
+         */
+        sure::normal::Normal calculateNormal() const;
+
+      protected:
+
+        //! Indices of the unique second moments
+        enum SecondMoment { XX = 0, XY, XZ, YY, YZ, ZZ, SECOND_MOMENTS };
+
+        double pointSum_[3];
+        double pointSqrSum_[SECOND_MOMENTS];
+        float colorSum_[3];
+        unsigned points_ : 28;
+        unsigned flag_ : 4;
+
+      private:
+
+        friend std::ostream& operator<<(std::ostream& stream, const PointMoments& p);
+
+    };
+
+    std::ostream& operator<<(std::ostream& stream, const PointMoments& rhs);
+
+  }
+}
+
+#endif /* SURE_PAYLOAD_MOMENTS_H_ */
@@ -0,0 +1,151 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef SURE_PAYLOAD_TABLES_H_
+#define SURE_PAYLOAD_TABLES_H_
+
+#include <vector>
+
+#include <Eigen/StdVector>
+
+#include <sure/data/typedef.h>
+#include <sure/normal/normal.h>
+#include <sure/normal/normal_histogram.h>
+
+namespace sure
+{
+  namespace payload
+  {
+
+    /**
+     * Normals of all octree nodes in a single depth, stored as structure of arrays.
+     * Element i belongs to the node with index i in that depth, see Node::index().
+     */
+    class NormalTable
+    {
+      public:
+
+        typedef std::vector<sure::normal::Normal, Eigen::aligned_allocator<sure::normal::Normal> > NormalVector;
+        typedef std::vector<sure::normal::NormalHistogram> HistogramVector;
+
+        NormalTable() : depth_(0) { }
+
+        //! Resets the table to size uncalculated normals for the nodes in a given depth. Keeps the memory
+        void reset(unsigned depth, std::size_t size)
+        {
+          depth_ = depth;
+          normals_.assign(size, sure::normal::Normal());
+          histograms_.assign(size, sure::normal::NormalHistogram());
+        }
+
+        void clear()
+        {
+          depth_ = 0;
+          normals_.clear();
+          histograms_.clear();
+        }
+
+        //! True, if the table stores the normals of the nodes in the given depth
+        bool contains(unsigned depth) const { return depth == depth_ && !normals_.empty(); }
+
+        unsigned depth() const { return depth_; }
+        std::size_t size() const { return normals_.size(); }
+
+        // Stores the normals
+        NormalVector normals_;
+
+        // Stores the discretized normals
+        HistogramVector histograms_;
+
+      protected:
+
+        unsigned depth_;
+
+    };
+
+    /**
+     * Entropy information of all octree nodes in a single depth, stored as structure of arrays.
+     * Element i belongs to the node with index i in that depth, see Node::index().
+     */
+    class EntropyTable
+    {
+      public:
+
+        EntropyTable() : depth_(0) { }
+
+        //! Resets the table to size uncalculated nodes in a given depth. Keeps the memory
+        void reset(unsigned depth, std::size_t size)
+        {
+          depth_ = depth;
+          entropy_.assign(size, 0.0);
+          cornerness_.assign(size, 0.0);
+          flags_.assign(size, NOT_CALCULATED);
+        }
+
+        void clear()
+        {
+          depth_ = 0;
+          entropy_.clear();
+          cornerness_.clear();
+          flags_.clear();
+        }
+
+        //! True, if the table stores the entropy of the nodes in the given depth
+        bool contains(unsigned depth) const { return depth == depth_ && !entropy_.empty(); }
+
+        unsigned depth() const { return depth_; }
+        std::size_t size() const { return entropy_.size(); }
+
+        // Stores the calculated entropy
+        std::vector<Scalar> entropy_;
+
+        // Stores the calculated cornerness
+        std::vector<Scalar> cornerness_;
+
+        /**
+         * Stores the current status of the nodes concerning entropy calculation.
+         * Nodes inept for a feature will be flagged appropriate and skipped in following calculation steps
+         */
+        std::vector<MaximumFlag> flags_;
+
+      protected:
+
+        unsigned depth_;
+
+    };
+
+  }
+}
+
+#endif /* SURE_PAYLOAD_TABLES_H_ */
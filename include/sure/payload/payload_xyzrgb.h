@@ -88,6 +88,17 @@ namespace sure
           return *this;
         }
 
+        //! Removes the points of rhs, the point flag is kept
+        PointsRGB& operator-=(const PointsRGB& rhs)
+        {
+          this->points_ -= rhs.points_;
+          this->colorSum_ -= rhs.colorSum_;
+          this->pointSqrSum_ -= rhs.pointSqrSum_;
+          this->pointSum_ -= rhs.pointSum_;
+          this->pointMean_ = this->pointSum_ / (Scalar) this->points_;
+          return *this;
+        }
+
         void clear()
         {
           colorSum_ = pointSum_ = Vector3::Zero();
@@ -35,11 +35,13 @@
 #define SURE_3D_H_
 
 #include <sure/data/configuration.h>
+#include <sure/data/statistics.h>
 #include <sure/memory/fixed_size_allocator.h>
 
 #include <sure/normal/normal_estimation.h>
-#include <sure/payload/payload_normal.h>
-#include <sure/payload/payload_xyzrgb.h>
+#include <sure/normal/organized_normal_estimation.h>
+#include <sure/payload/payload_moments.h>
+#include <sure/payload/payload_tables.h>
 
 #include <sure/data/range_image.h>
 #include <sure/octree/octree_node.h>
@@ -62,12 +64,11 @@ namespace sure
 
       typedef pcl::PointCloud<pcl::PointXYZRGB> PointCloud;
 
-      typedef sure::payload::PointsRGB FixedPayload;
+      typedef sure::payload::PointMoments FixedPayload;
       typedef sure::octree::Node<FixedPayload> Node;
-      typedef sure::memory::FixedSizeAllocator<Node> Allocator;
-
       typedef sure::range_image::RangeImage<pcl::PointXYZRGB> RangeImage;
       typedef sure::octree::Octree<FixedPayload> Octree;
+      typedef Octree::Allocator Allocator;
 
       typedef sure::feature::Feature Feature;
 
@@ -90,6 +91,11 @@ namespace sure
        */
       Configuration config;
 
+      /**
+       * Timings and counters of the last feature calculation
+       */
+      Statistics statistics;
+
       /**
        * Main function for feature calculation
        * @return true, if features were calculated, false otherwise
@@ -111,8 +117,15 @@ namespace sure
       bool extractKeypoints();
       bool extractFeatures();
 
-      sure::memory::FixedSizeAllocatorWithDirectAccess<sure::payload::NormalPayload> normalAllocator_;
-      sure::memory::FixedSizeAllocatorWithDirectAccess<sure::payload::EntropyPayload> entropyAllocator_;
+      //! Side tables of the normal depth and the sampling depth, both may be the same depth
+      sure::payload::NormalTable normals_;
+      sure::payload::EntropyTable entropy_;
+
+      //! Integral images of the moments of organized point clouds for the normal estimation
+      normal::IntegralMomentImage momentImage_;
+
+      keypoints::ScaleSpacePyramid scaleSpace_;
+      keypoints::NeighborhoodCache neighborhoods_;
 
   };
 
@@ -0,0 +1,162 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+
+#include <sure/sure.h>
+
+#include <pcl/point_cloud.h>
+#include <pcl/common/time.h>
+
+//! converts rgb-ints to the pcl-float for storing rgb-values
+inline float createPCLRGBfromInt(int r, int g, int b)
+{
+  int32_t rgb = (r << 16) | (g << 8) | b;
+  return *(float *)(&rgb);
+}
+
+/**
+ * Intersects a ray from the origin with an axis aligned box. Returns the distance along the ray or a negative value.
+ */
+float intersectBox(const Eigen::Vector3f& origin, const Eigen::Vector3f& ray, float halfSize)
+{
+  float tMin(-1e9f), tMax(1e9f);
+  for(int i=0; i<3; ++i)
+  {
+    if( fabs(ray[i]) < 1e-9f )
+    {
+      if( fabs(origin[i]) > halfSize )
+      {
+        return -1.f;
+      }
+      continue;
+    }
+    float t0 = (-halfSize - origin[i]) / ray[i];
+    float t1 = (halfSize - origin[i]) / ray[i];
+    tMin = std::max(tMin, std::min(t0, t1));
+    tMax = std::min(tMax, std::max(t0, t1));
+  }
+  return (tMin <= tMax && tMin > 0.f) ? tMin : -1.f;
+}
+
+/**
+ * Generates an organized pointcloud as seen by a depth camera: A rotated cube of 0.6 m edge length
+ * in front of a wall, rotating with the frame number to simulate motion.
+ */
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr generateFrame(unsigned width, unsigned height, unsigned frame)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  cloud->width = width;
+  cloud->height = height;
+  cloud->points.resize(width * height);
+
+  const float focalLength = 525.f * (float) width / 640.f;
+  const float wallDistance = 3.f;
+  const float cubeHalfSize = 0.3f;
+  const Eigen::Vector3f cubeCenter(0.f, 0.f, 1.5f);
+  const Eigen::Matrix3f rotation(Eigen::AngleAxisf(M_PI_4 + 0.02f * (float) frame, Eigen::Vector3f::UnitY()) * Eigen::AngleAxisf(M_PI_4, Eigen::Vector3f::UnitX()));
+  const Eigen::Matrix3f inverse(rotation.transpose());
+
+  for(unsigned v=0; v<height; ++v)
+  {
+    for(unsigned u=0; u<width; ++u)
+    {
+      const Eigen::Vector3f ray(((float) u - 0.5f * (float) width) / focalLength, ((float) v - 0.5f * (float) height) / focalLength, 1.f);
+      float depth = wallDistance;
+      int r(200), g(200), b(200);
+
+      // ray and origin in the coordinate system of the cube
+      float t = intersectBox(inverse * (-cubeCenter), inverse * ray, cubeHalfSize);
+      if( t > 0.f )
+      {
+        depth = t;
+        Eigen::Vector3f local = inverse * (ray * t - cubeCenter);
+        r = 255.f * (local[0] + cubeHalfSize) / (2.f * cubeHalfSize);
+        g = 255.f * (local[1] + cubeHalfSize) / (2.f * cubeHalfSize);
+        b = 255.f * (local[2] + cubeHalfSize) / (2.f * cubeHalfSize);
+      }
+
+      pcl::PointXYZRGB& p = cloud->points[v * width + u];
+      p.x = ray[0] * depth;
+      p.y = ray[1] * depth;
+      p.z = depth;
+      p.rgb = createPCLRGBfromInt(std::min(std::max(r, 0), 255), std::min(std::max(g, 0), 255), std::min(std::max(b, 0), 255));
+    }
+  }
+  return cloud;
+}
+
+/**
+ * Runs the feature extraction on a number of frames and returns the frames per second
+ */
+double runFrames(sure::SUREFeatureExtractor& sure, unsigned frames, unsigned width, unsigned height)
+{
+  std::vector<pcl::PointCloud<pcl::PointXYZRGB>::Ptr> clouds;
+  for(unsigned i=0; i<frames; ++i)
+  {
+    clouds.push_back(generateFrame(width, height, i));
+  }
+
+  pcl::StopWatch watch;
+  for(unsigned i=0; i<frames; ++i)
+  {
+    sure.setInputCloud(clouds[i]);
+    sure.calculateSURE();
+  }
+  return (double) frames / (watch.getTime() / 1000.0);
+}
+
+int main(int argc, char** argv)
+{
+  unsigned frames = (argc > 1) ? atoi(argv[1]) : 30;
+  unsigned width = (argc > 2) ? atoi(argv[2]) : 320;
+  unsigned height = (argc > 3) ? atoi(argv[3]) : 240;
+
+  std::cout << "SURE frames per second benchmark - " << frames << " frames of " << width << "x" << height << " points\n";
+  std::cout << std::setprecision(2);
+  std::cout.setf(std::ios_base::fixed);
+
+  for(unsigned mode=0; mode<2; ++mode)
+  {
+    sure::SUREFeatureExtractor sure;
+    sure.config.ReuseMemoryBetweenFrames = (mode == 1);
+    double fps = runFrames(sure, frames, width, height);
+    std::cout << (sure.config.ReuseMemoryBetweenFrames ? "Reusing memory between frames:      " : "Reallocating memory for each frame: ") << fps << " fps\n";
+  }
+  return 0;
+}
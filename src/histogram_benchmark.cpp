@@ -0,0 +1,279 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+#include <algorithm>
+#include <string>
+
+#include <sure/normal/histogram_kernel.h>
+#include <sure/normal/normal_histogram.h>
+#include <sure/normal/cross_product_histogram.h>
+
+#include <pcl/common/time.h>
+
+typedef std::vector<sure::NormalType, sure::NormalTypeAllocator> NormalList;
+
+const char* KERNEL_NAMES[] = { "scalar", "sse", "avx2" };
+
+//! Generates uniformly distributed unit vectors
+NormalList createNormals(unsigned number)
+{
+  NormalList normals(number);
+  srand(42);
+  for(unsigned i=0; i<number; ++i)
+  {
+    sure::NormalType n;
+    do
+    {
+      for(int j=0; j<3; ++j)
+      {
+        n[j] = 2.0 * (double) rand() / (double) RAND_MAX - 1.0;
+      }
+    } while( n.squaredNorm() > 1.0 || n.squaredNorm() < 1e-6 );
+    normals[i] = n.normalized();
+  }
+  return normals;
+}
+
+/**
+ * Weights a normal in double precision against the reference vectors, as done before the kernels existed.
+ * Serves as reference for the deviation of the single precision kernels.
+ */
+void referenceBinWeights(const sure::NormalType& normal, sure::Scalar influenceRadius, sure::HistoType* weights)
+{
+  for(int i=0; i<sure::normal::NORMAL_HISTOGRAM_SIZE; ++i)
+  {
+    sure::Scalar distance = normal.dot(sure::normal::REFERENCE_VECTORS[i]);
+    weights[i] = distance > influenceRadius ? (distance - influenceRadius) / (1.0 - influenceRadius) : 0.0;
+  }
+}
+
+/**
+ * Creates histograms of regions with a varying number of normals, as integrated for the entropy calculation
+ */
+std::vector<sure::normal::NormalHistogram> createHistograms(const NormalList& normals, unsigned number)
+{
+  std::vector<sure::normal::NormalHistogram> histograms(number);
+  for(unsigned i=0, n=0; i<histograms.size(); ++i)
+  {
+    sure::normal::NormalHistogram single;
+    single.setInfluenceRadius(sure::normal::DEFAULT_NORMAL_HISTOGRAM_INFLUENCE);
+    for(unsigned j=(i % 32) + 1; j>0; --j, n=(n+1) % normals.size())
+    {
+      single.insertNormal(normals[n]);
+      histograms[i] += single;
+    }
+  }
+  return histograms;
+}
+
+/**
+ * Maximum deviation of the approximate from the exact raw entropy with the current kernel. The raw entropy is normalized
+ * by log2 of the histogram size, the error bound applies to the raw entropy
+ */
+float maxApproximateEntropyError(const std::vector<sure::normal::NormalHistogram>& histograms)
+{
+  const float maxEntropy = log((float) sure::normal::NORMAL_HISTOGRAM_SIZE) / log(2.f);
+  float maxError(0.f);
+  for(unsigned i=0; i<histograms.size(); ++i)
+  {
+    maxError = std::max(maxError, (float) fabs(histograms[i].calculateEntropy(true) - histograms[i].calculateEntropy(false)) * maxEntropy);
+  }
+  return maxError;
+}
+
+//! Allows for single precision rounding of the sums on top of the bound of the logarithm
+bool isWithinBound(float error)
+{
+  return error < sure::normal::APPROXIMATE_LOG2_MAX_ERROR + 1e-5f;
+}
+
+/**
+ * Compares the approximate entropy of every supported kernel with the exact entropy on a small set of histograms
+ * @return Zero, if all kernels stay within the error bound
+ */
+int checkApproximateEntropy()
+{
+  const std::vector<sure::normal::NormalHistogram> histograms = createHistograms(createNormals(1000), 500);
+  const sure::normal::HistogramKernel defaultKernel = sure::normal::getHistogramKernel();
+  bool withinBound(true);
+  for(int k=sure::normal::SCALAR_HISTOGRAM_KERNEL; k<=sure::normal::AVX2_HISTOGRAM_KERNEL; ++k)
+  {
+    if( !sure::normal::setHistogramKernel((sure::normal::HistogramKernel) k) )
+    {
+      std::cout << std::setw(7) << KERNEL_NAMES[k] << ": not supported\n";
+      continue;
+    }
+    const float error = maxApproximateEntropyError(histograms);
+    withinBound = withinBound && isWithinBound(error);
+    std::cout << std::setw(7) << KERNEL_NAMES[k] << ": max. raw entropy error " << std::scientific << error << std::fixed << (isWithinBound(error) ? "" : " - exceeds the bound") << "\n";
+  }
+  sure::normal::setHistogramKernel(defaultKernel);
+  return withinBound ? 0 : 1;
+}
+
+int main(int argc, char** argv)
+{
+  if( argc > 1 && std::string(argv[1]) == "--check" )
+  {
+    return checkApproximateEntropy();
+  }
+  unsigned number = (argc > 1) ? atoi(argv[1]) : 100000;
+  unsigned repetitions = (argc > 2) ? atoi(argv[2]) : 20;
+  const NormalList normals = createNormals(number);
+  const sure::Scalar influence = cos(sure::normal::DEFAULT_NORMAL_HISTOGRAM_INFLUENCE);
+
+  std::cout << "SURE histogram insertion benchmark - " << number << " normals, " << repetitions << " repetitions\n";
+  std::cout << std::setprecision(2);
+  std::cout.setf(std::ios_base::fixed);
+
+  sure::HistoType weights[sure::normal::PADDED_HISTOGRAM_SIZE], referenceWeights[sure::normal::PADDED_HISTOGRAM_SIZE];
+  const sure::normal::HistogramKernel defaultKernel = sure::normal::getHistogramKernel();
+  for(int k=sure::normal::SCALAR_HISTOGRAM_KERNEL; k<=sure::normal::AVX2_HISTOGRAM_KERNEL; ++k)
+  {
+    sure::normal::HistogramKernel kernel = (sure::normal::HistogramKernel) k;
+    if( !sure::normal::setHistogramKernel(kernel) )
+    {
+      std::cout << std::setw(7) << KERNEL_NAMES[k] << ": not supported\n";
+      continue;
+    }
+
+    // deviation from the double precision weights
+    float maxDeviation(0.f);
+    for(unsigned i=0; i<number; ++i)
+    {
+      sure::normal::calculateBinWeights(kernel, normals[i], influence, weights);
+      referenceBinWeights(normals[i], influence, referenceWeights);
+      for(int j=0; j<sure::normal::NORMAL_HISTOGRAM_SIZE; ++j)
+      {
+        maxDeviation = std::max(maxDeviation, (float) fabs(weights[j] - referenceWeights[j]));
+      }
+    }
+
+    float checksum(0.f);
+    pcl::StopWatch watch;
+    for(unsigned r=0; r<repetitions; ++r)
+    {
+      for(unsigned i=0; i<number; ++i)
+      {
+        sure::normal::calculateBinWeights(kernel, normals[i], influence, weights);
+        checksum += weights[i % sure::normal::NORMAL_HISTOGRAM_SIZE];
+      }
+    }
+    double weightTime = watch.getTime();
+
+    sure::normal::NormalHistogram histogram;
+    histogram.setInfluenceRadius(sure::normal::DEFAULT_NORMAL_HISTOGRAM_INFLUENCE);
+    watch.reset();
+    for(unsigned r=0; r<repetitions; ++r)
+    {
+      for(unsigned i=0; i<number; ++i)
+      {
+        histogram.insertNormal(normals[i]);
+        checksum += histogram.calculateEntropy();
+      }
+    }
+    double normalTime = watch.getTime();
+
+    sure::normal::CrossProductHistogram crossProducts;
+    crossProducts.setInfluenceRadius(sure::normal::DEFAULT_NORMAL_HISTOGRAM_INFLUENCE);
+    watch.reset();
+    for(unsigned r=0; r<repetitions; ++r)
+    {
+      for(unsigned i=1; i<number; ++i)
+      {
+        crossProducts.insertCrossProduct(normals[i-1], normals[i]);
+      }
+      crossProducts.clear();
+    }
+    double crossProductTime = watch.getTime();
+
+    const double insertions = (double) number * (double) repetitions;
+    std::cout << std::setw(7) << KERNEL_NAMES[k] << ": bin weights " << (weightTime * 1e6) / insertions << " ns/normal - normal histogram " << (normalTime * 1e6) / insertions << " ns/normal";
+    std::cout << " - cross-product histogram " << (crossProductTime * 1e6) / insertions << " ns/pair - max. deviation " << std::scientific << maxDeviation << std::fixed;
+    std::cout << (kernel == defaultKernel ? " (default)" : "") << " [" << checksum << "]\n";
+  }
+
+  const std::vector<sure::normal::NormalHistogram> histograms = createHistograms(normals, number / 10);
+
+  std::cout << "SURE entropy benchmark - " << histograms.size() << " histograms, " << repetitions << " repetitions\n";
+  float exactChecksum(0.f);
+  pcl::StopWatch watch;
+  for(unsigned r=0; r<repetitions; ++r)
+  {
+    for(unsigned i=0; i<histograms.size(); ++i)
+    {
+      exactChecksum += histograms[i].calculateEntropy(false);
+    }
+  }
+  const double evaluations = (double) histograms.size() * (double) repetitions;
+  std::cout << std::setw(7) << "exact" << ": " << (watch.getTime() * 1e6) / evaluations << " ns/histogram [" << exactChecksum << "]\n";
+
+  bool withinBound(true);
+  for(int k=sure::normal::SCALAR_HISTOGRAM_KERNEL; k<=sure::normal::AVX2_HISTOGRAM_KERNEL; ++k)
+  {
+    sure::normal::HistogramKernel kernel = (sure::normal::HistogramKernel) k;
+    if( !sure::normal::setHistogramKernel(kernel) )
+    {
+      continue;
+    }
+
+    const float maxError = maxApproximateEntropyError(histograms);
+    withinBound = withinBound && isWithinBound(maxError);
+
+    float checksum(0.f);
+    watch.reset();
+    for(unsigned r=0; r<repetitions; ++r)
+    {
+      for(unsigned i=0; i<histograms.size(); ++i)
+      {
+        checksum += histograms[i].calculateEntropy(true);
+      }
+    }
+    std::cout << std::setw(7) << KERNEL_NAMES[k] << ": " << (watch.getTime() * 1e6) / evaluations << " ns/histogram - max. raw entropy error " << std::scientific << maxError << std::fixed;
+    std::cout << (kernel == defaultKernel ? " (default)" : "") << " [" << checksum << "]\n";
+  }
+  sure::normal::setHistogramKernel(defaultKernel);
+
+  if( !withinBound )
+  {
+    std::cout << "Approximate entropy exceeds its error bound\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,182 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+#include <pcl/point_types.h>
+#include <pcl/point_cloud.h>
+
+#include <sure/octree/octree.h>
+#include <sure/octree/linear_octree.h>
+#include <sure/payload/payload_moments.h>
+
+typedef sure::payload::PointMoments FixedPayload;
+typedef sure::octree::Octree<FixedPayload> Octree;
+typedef sure::octree::LinearOctree<FixedPayload> LinearOctree;
+
+//! Uniformly distributed random number in [min, max)
+inline float random(float min, float max)
+{
+  return min + (max - min) * ((float) rand() / ((float) RAND_MAX + 1.f));
+}
+
+/**
+ * Creates a random pointcloud: A noisy sphere surface, uniformly distributed points and a few invalid points
+ */
+pcl::PointCloud<pcl::PointXYZRGB> createPointCloud(unsigned number, const Eigen::Vector3f& center, float radius)
+{
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  for(unsigned i=0; i<number; ++i)
+  {
+    pcl::PointXYZRGB p;
+    Eigen::Vector3f v(random(-1.f, 1.f), random(-1.f, 1.f), random(-1.f, 1.f));
+    if( i % 2 == 0 && v.norm() > 1e-3f )
+    {
+      v *= (radius + random(-0.01f, 0.01f)) / v.norm();
+    }
+    else
+    {
+      v *= radius;
+    }
+    p.x = center[0] + v[0];
+    p.y = center[1] + v[1];
+    p.z = center[2] + v[2];
+    if( i % 97 == 0 )
+    {
+      p.x = p.y = p.z = std::numeric_limits<float>::quiet_NaN();
+    }
+    cloud.push_back(p);
+  }
+  return cloud;
+}
+
+//! Compares two sums, which may only differ in their summation order
+inline bool equalSums(double a, double b)
+{
+  return fabs(a - b) <= 1e-4 * std::max(1.0, std::max(fabs(a), fabs(b)));
+}
+
+bool equalPayloads(const FixedPayload& a, const FixedPayload& b)
+{
+  if( a.getPointCount() != b.getPointCount() || a.getPointFlag() != b.getPointFlag() )
+  {
+    return false;
+  }
+  const sure::Vector3 sumA(a.getPosSum()), sumB(b.getPosSum());
+  const sure::Matrix3 sqrA(a.getPosSqrSum()), sqrB(b.getPosSqrSum());
+  for(int i=0; i<3; ++i)
+  {
+    if( !equalSums(sumA[i], sumB[i]) )
+    {
+      return false;
+    }
+    for(int j=0; j<3; ++j)
+    {
+      if( !equalSums(sqrA(i, j), sqrB(i, j)) )
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+/**
+ * Builds both octrees from the same point clouds and compares the payload integrated in random areas
+ * @return Number of areas with differing payloads
+ */
+unsigned checkIntegratedPayloads(sure::OctreeConstructionMode mode, float minNodeSize, float expansion, const sure::Vector3& center, unsigned areas)
+{
+  const Eigen::Vector3f cloudCenter(center[0] + 0.1f, center[1] - 0.2f, center[2] + 0.3f);
+  const pcl::PointCloud<pcl::PointXYZRGB> cloud = createPointCloud(20000, cloudCenter, 1.f);
+  const pcl::PointCloud<pcl::PointXYZRGB> artificial = createPointCloud(2000, cloudCenter, 0.5f);
+
+  Octree octree;
+  octree.setConstructionMode(mode);
+  LinearOctree linearOctree;
+  if( !octree.initialize(minNodeSize, expansion, 1000000, center) || !linearOctree.initialize(minNodeSize, expansion, center) )
+  {
+    std::cout << "Initialization failed for a minimum node size of " << minNodeSize << "\n";
+    return areas;
+  }
+  octree.addPointCloud(cloud);
+  octree.addArtificialPointCloud(artificial);
+  linearOctree.addPointCloud(cloud);
+  linearOctree.addArtificialPointCloud(artificial);
+
+  unsigned errors(0);
+  for(unsigned i=0; i<areas; ++i)
+  {
+    const sure::Vector3 point(cloudCenter[0] + random(-1.2f, 1.2f), cloudCenter[1] + random(-1.2f, 1.2f), cloudCenter[2] + random(-1.2f, 1.2f));
+    const float radius = random(minNodeSize, 0.5f);
+    FixedPayload payload, linearPayload;
+    octree.integratePayload(point, radius, payload);
+    linearOctree.integratePayload(point, radius, linearPayload);
+    if( !equalPayloads(payload, linearPayload) )
+    {
+      errors++;
+    }
+  }
+  return errors;
+}
+
+/**
+ * Checks that the linear octree integrates the same payloads as the octree, for every construction mode and for
+ * minimum node sizes other than the default
+ */
+int main(int argc, char** argv)
+{
+  const char* MODE_NAMES[] = { "incremental", "morton sorted", "concurrent" };
+  const sure::OctreeConstructionMode modes[] = { sure::INCREMENTAL_INSERTION, sure::MORTON_SORTED_INSERTION, sure::CONCURRENT_INSERTION };
+  const float minNodeSizes[] = { 0.01f, 0.02f, 0.04f };
+  const unsigned areas = 500;
+
+  srand(42);
+  unsigned errors(0);
+  for(unsigned m=0; m<3; ++m)
+  {
+    for(unsigned s=0; s<3; ++s)
+    {
+      const unsigned e = checkIntegratedPayloads(modes[m], minNodeSizes[s], 20.48f, sure::Vector3(0.5f, -1.f, 2.f), areas);
+      std::cout << MODE_NAMES[m] << " insertion, minimum node size " << minNodeSizes[s] << ": " << e << " of " << areas << " integrated payloads differ\n";
+      errors += e;
+    }
+  }
+  return errors == 0 ? 0 : 1;
+}
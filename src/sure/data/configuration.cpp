@@ -63,7 +63,7 @@ std::ostream& sure::operator<<(std::ostream& stream, const sure::Configuration&
     stream << "\n";
   }
 
-  stream << "# Improve Feature Localization: " << config.ImproveLocalization << " - Additional Points on Depth Borders: " << config.AdditionalPointsOnDepthBorders << " - Ignore Background Detections: " << config.IgnoreBackgroundDetections << "\n";
+  stream << "# Improve Feature Localization: " << config.ImproveLocalization << " - Additional Points on Depth Borders: " << config.AdditionalPointsOnDepthBorders << " (maximum " << config.MaximumPointsOnDepthBorders << ") - Ignore Background Detections: " << config.IgnoreBackgroundDetections << "\n";
   stream << "# Entropy Calculation: ";
   switch(config.EntropyMode)
   {
@@ -78,7 +78,23 @@ std::ostream& sure::operator<<(std::ostream& stream, const sure::Configuration&
       stream << " Cross-products between main normal an neighboring normals\n";
       break;
   }
+  stream << "# Octree Construction: ";
+  switch(config.OctreeConstruction)
+  {
+    default:
+    case INCREMENTAL_INSERTION:
+      stream << " Incremental insertion\n";
+      break;
+    case MORTON_SORTED_INSERTION:
+      stream << " Morton sorted, bottom-up\n";
+      break;
+    case CONCURRENT_INSERTION:
+      stream << " Concurrent, lock-free\n";
+      break;
+  }
+  stream << "# Reuse Memory Between Frames: " << config.ReuseMemoryBetweenFrames << " - Summed-Volume Table Maximum Cells: " << config.SummedVolumeTableMaximumCells << "\n";
+  stream << "# Number of Threads: " << config.NumberOfThreads << " - Scale-Space Entropy: " << config.ScaleSpaceEntropy << " - Approximate Entropy: " << config.ApproximateEntropy << " - Cache Neighborhoods: " << config.CacheNeighborhoods << " - Organized Normal Estimation: " << config.OrganizedNormalEstimation << "\n";
   return stream;
 }
 
-BOOST_CLASS_VERSION(sure::Configuration, 8)
+BOOST_CLASS_VERSION(sure::Configuration, 17)
@@ -0,0 +1,128 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sure/data/statistics.h>
+
+#include <algorithm>
+#include <iomanip>
+
+const char* sure::getMaximumFlagName(MaximumFlag flag)
+{
+  switch(flag)
+  {
+    case IS_MAXIMUM:
+      return "maximum";
+    case POSSIBLE:
+      return "possible";
+    case NOT_CALCULATED:
+      return "not calculated";
+    case ENTROPY_TOO_LOW:
+      return "entropy too low";
+    case CORNERNESS_TOO_LOW:
+      return "cornerness too low";
+    case SUPPRESSED:
+      return "suppressed";
+    case REDUNDANT:
+      return "redundant";
+    case DISTANCE_TOO_HIGH:
+      return "distance too high";
+    case BACKGROUND_EDGE:
+      return "background edge";
+    case ARTIFICIAL_POINTS:
+      return "artificial points";
+  }
+  return "unknown";
+}
+
+const char* sure::Statistics::getStageName(Stage stage)
+{
+  switch(stage)
+  {
+    case OCTREE_STAGE:
+      return "octree";
+    case NORMAL_STAGE:
+      return "normals";
+    case KEYPOINT_STAGE:
+      return "keypoints";
+    case FEATURE_STAGE:
+      return "features";
+    default:
+      break;
+  }
+  return "unknown";
+}
+
+void sure::Statistics::clear()
+{
+  for(int i=0; i<NUMBER_OF_STAGES; ++i)
+  {
+    stages[i] = Timing();
+  }
+  total = Timing();
+  scales.clear();
+  nodesPerDepth.clear();
+  points = artificialPoints = 0;
+  normals = imageNormals = keypoints = descriptors = 0;
+  std::fill(flagCounts, flagCounts + NUMBER_OF_MAXIMUM_FLAGS, 0u);
+  allocatorSize = allocatorCapacity = allocatorHighWaterMark = allocatorMemory = 0;
+}
+
+std::ostream& sure::operator<<(std::ostream& stream, const sure::Statistics& statistics)
+{
+  stream << std::setprecision(1);
+  stream.setf(std::ios_base::fixed);
+  stream << "# Points: " << statistics.points << " - artificial points: " << statistics.artificialPoints << " - normals: " << statistics.normals << " (" << statistics.imageNormals << " from integral images) - keypoints: " << statistics.keypoints << " - descriptors: " << statistics.descriptors << "\n";
+  for(int i=0; i<Statistics::NUMBER_OF_STAGES; ++i)
+  {
+    stream << "# Stage " << Statistics::getStageName((Statistics::Stage) i) << ": " << statistics.stages[i].wall << "ms wall, " << statistics.stages[i].cpu << "ms cpu\n";
+  }
+  stream << "# Total: " << statistics.total.wall << "ms wall, " << statistics.total.cpu << "ms cpu\n";
+  for(unsigned i=0; i<statistics.scales.size(); ++i)
+  {
+    const ScaleStatistics& scale = statistics.scales[i];
+    stream << "# Scale " << floor(scale.scale*100.f + 0.5f) << "cm: " << scale.time.wall << "ms wall, " << scale.time.cpu << "ms cpu - keypoints: " << scale.keypoints << " - redundant: " << scale.redundantKeypoints << "\n";
+  }
+  stream << "# Nodes per depth:";
+  for(unsigned i=0; i<statistics.nodesPerDepth.size(); ++i)
+  {
+    stream << " " << statistics.nodesPerDepth[i];
+  }
+  stream << "\n# Flags on all scales:";
+  for(int i=0; i<NUMBER_OF_MAXIMUM_FLAGS; ++i)
+  {
+    stream << " " << getMaximumFlagName((MaximumFlag) i) << ": " << statistics.flagCounts[i] << (i < NUMBER_OF_MAXIMUM_FLAGS-1 ? "," : "\n");
+  }
+  stream << "# Node pool: " << statistics.allocatorSize << " used, " << statistics.allocatorHighWaterMark << " high water mark, " << statistics.allocatorCapacity << " capacity, " << statistics.allocatorMemory << " bytes\n";
+  return stream;
+}
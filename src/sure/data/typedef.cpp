@@ -34,6 +34,10 @@
 #include <sure/data/typedef.h>
 #include <iostream>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
 const int sure::getNormalHistogramSize(unsigned numberOfPolarBins)
 {
   const Scalar polarBinSize = M_PI / (Scalar) numberOfPolarBins;
@@ -65,3 +69,11 @@ const sure::Scalar sure::getNormalHistogramBinSize(unsigned numberOfPolarBins)
   return (avgBinSize / (Scalar) histogramSize);
 }
 
+int sure::getNumberOfThreads(int requested)
+{
+#ifdef _OPENMP
+  return requested > 0 ? requested : omp_get_max_threads();
+#else
+  return 1;
+#endif
+}
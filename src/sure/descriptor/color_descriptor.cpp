@@ -92,7 +92,10 @@ void sure::descriptor::ColorDescriptor::clear()
 
 void sure::descriptor::ColorDescriptor::normalize()
 {
-  saturationBalance_ /= weight_;
+  if( weight_ > 0.0 )
+  {
+    saturationBalance_ /= weight_;
+  }
   sure::descriptor::ColorHistogram::normalize();
 }
 
@@ -109,13 +112,68 @@ void sure::descriptor::ColorDescriptor::insertValue(Scalar hue, Scalar saturatio
 
 sure::Scalar sure::descriptor::ColorDescriptor::distanceTo(const ColorDescriptor& rhs) const
 {
-  Scalar distance = 0.0;
-  std::vector<double> lhsVec, rhsVec;
-  ColorHistogram::fillVector(lhsVec);
-  rhs.fillVector(rhsVec);
-  lhsVec.push_back(saturationBalance_);
-  rhsVec.push_back(rhs.saturationBalance_);
-  distance += emd_hat<double>()(rhsVec, lhsVec, DISTANCE_MATRIX);
+  double lhsValues[COLOR_DISTANCE_VECTOR_SIZE], rhsValues[COLOR_DISTANCE_VECTOR_SIZE];
+  getDistanceVector(lhsValues);
+  rhs.getDistanceVector(rhsValues);
+  return distance(lhsValues, rhsValues);
+}
+
+void sure::descriptor::ColorDescriptor::getDistanceVector(double* values) const
+{
+  for(int i=0; i<COLOR_DESCRIPTOR_SIZE; ++i)
+  {
+    if( weight_ > 0.0 )
+    {
+      values[i] = (weight_ == 1.0) ? array_[i] : array_[i] / weight_;
+    }
+    else
+    {
+      values[i] = 0.0;
+    }
+  }
+  values[COLOR_DESCRIPTOR_SIZE] = saturationBalance_;
+}
+
+sure::Scalar sure::descriptor::ColorDescriptor::distance(const double* lhs, const double* rhs)
+{
+  // the closed form below only holds for distances capped at two bins
+  if( MAX_EARTH_MOVERS_DISTANCE != 2.0 )
+  {
+    std::vector<double> lhsVec(lhs, lhs + COLOR_DISTANCE_VECTOR_SIZE), rhsVec(rhs, rhs + COLOR_DISTANCE_VECTOR_SIZE);
+    return emd_hat<double>()(rhsVec, lhsVec, DISTANCE_MATRIX) * (1.0 / MAX_EARTH_MOVERS_DISTANCE);
+  }
+
+  // With hue bins one apart costing 1 and everything else 2, the mass shared by a bin stays in place and the
+  // remaining mass costs 2, minus 1 for every unit moved between neighboring hue bins. The neighboring moves form
+  // a maximum flow along the chain of hue bins, which a greedy sweep from the first bin finds exactly
+  double lhsMass = 0.0, rhsMass = 0.0;
+  double lhsSurplus = 0.0, rhsSurplus = 0.0;
+  double neighborFlow = 0.0;
+  double carry = 0.0;
+  for(int i=0; i<COLOR_DISTANCE_VECTOR_SIZE; ++i)
+  {
+    lhsMass += lhs[i];
+    rhsMass += rhs[i];
+    double surplus = lhs[i] - rhs[i];
+    if( surplus > 0.0 )
+    {
+      lhsSurplus += surplus;
+    }
+    else
+    {
+      rhsSurplus -= surplus;
+    }
+    if( i < COLOR_DESCRIPTOR_SIZE && carry * surplus < 0.0 )
+    {
+      const double flow = std::min(fabs(carry), fabs(surplus));
+      neighborFlow += flow;
+      surplus += (surplus > 0.0) ? -flow : flow;
+    }
+    carry = surplus;
+  }
+
+  // the unmatched mass is charged the maximum distance, as in emd_hat
+  const double distance = MAX_EARTH_MOVERS_DISTANCE * (std::min(lhsSurplus, rhsSurplus) + fabs(lhsMass - rhsMass)) - neighborFlow;
   return (distance * (1.0 / MAX_EARTH_MOVERS_DISTANCE));
 }
 
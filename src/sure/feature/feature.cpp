@@ -63,37 +63,82 @@ sure::Scalar sure::feature::Feature::distanceTo(const Feature& rhs, Scalar shape
   return (distance / (Scalar) descriptors_.size());
 }
 
-int sure::feature::Feature::createDescriptor(const NodeVector& nodes, Scalar referenceLightness, unsigned distanceClasses)
+int sure::feature::Feature::createDescriptor(const NodeVector& nodes, Scalar referenceLightness, unsigned distanceClasses, const NormalTable* normals)
 {
   int usedPoints(std::numeric_limits<int>::max());
-  resetDescriptor(distanceClasses);
-  usedPoints = std::min(usedPoints, createShapedescriptor(nodes));
+  prepareDescriptor(referenceLightness, distanceClasses);
+  usedPoints = std::min(usedPoints, createShapedescriptor(nodes, normals));
   usedPoints = std::min(usedPoints, createColordescriptor(nodes));
-  usedPoints = std::min(usedPoints, createLightnessdescriptor(nodes, referenceLightness));
+  usedPoints = std::min(usedPoints, createLightnessdescriptor(nodes));
+  finishDescriptor();
+  return usedPoints;
+}
+
+void sure::feature::Feature::prepareDescriptor(Scalar referenceLightness, unsigned distanceClasses)
+{
+  resetDescriptor(distanceClasses);
+  for(unsigned i=0; i<descriptors_.size(); ++i)
+  {
+    descriptors_[i].lightness().setLightness(referenceLightness);
+  }
+}
+
+void sure::feature::Feature::finishDescriptor()
+{
   normalizeDescriptor();
   hasDescriptor_ = true;
-  return usedPoints;
 }
 
-int sure::feature::Feature::createShapedescriptor(const NodeVector& nodes)
+bool sure::feature::Feature::insertShape(const Node* node, const NormalTable* normals)
+{
+  const Normal* normal = normals ? &normals->normals_[node->index()] : NULL;
+  if( !normal || !normal->isStable() )
+  {
+    return false;
+  }
+  HistoType alpha, phi, theta;
+  sure::descriptor::calculateSurfletPairRelations(position_, normal_.vector(), node->fixed().getMeanPosition(), normal->vector(), alpha, phi, theta);
+  if( std::isfinite(alpha) && std::isfinite(phi) && std::isfinite(theta) )
+  {
+    unsigned dClass = getDistanceClass(position_, node->fixed().getMeanPosition());
+    descriptors_.at(dClass).shape().insertValues(alpha, phi, theta);
+    return true;
+  }
+  return false;
+}
+
+bool sure::feature::Feature::insertColor(const Node* node)
+{
+  Scalar hue, saturation, lightness;
+  sure::descriptor::convertRGBtoHSL(node->fixed().getMeanColor()[0], node->fixed().getMeanColor()[1], node->fixed().getMeanColor()[2], hue, saturation, lightness);
+  if( std::isfinite(hue) && std::isfinite(saturation) )
+  {
+    unsigned dClass = getDistanceClass(position_, node->fixed().getMeanPosition());
+    descriptors_.at(dClass).color().insertValue(hue, saturation);
+    return true;
+  }
+  return false;
+}
+
+bool sure::feature::Feature::insertLightness(const Node* node)
+{
+  Scalar hue, saturation, lightness;
+  sure::descriptor::convertRGBtoHSL(node->fixed().getMeanColor()[0], node->fixed().getMeanColor()[1], node->fixed().getMeanColor()[2], hue, saturation, lightness);
+  if( std::isfinite(hue) && std::isfinite(saturation) )
+  {
+    unsigned dClass = getDistanceClass(position_, node->fixed().getMeanPosition());
+    descriptors_.at(dClass).lightness().insertValue(lightness);
+    return true;
+  }
+  return false;
+}
+
+int sure::feature::Feature::createShapedescriptor(const NodeVector& nodes, const NormalTable* normals)
 {
   int usedPoints(0);
   for(unsigned i=0; i<nodes.size(); ++i)
   {
-    Node* currNode = nodes[i];
-    NormalPayload* payload = currNode->opt() ? static_cast<NormalPayload*>(currNode->opt()) : NULL;
-    if( !payload || !payload->normal_.isStable() )
-    {
-      continue;
-    }
-    HistoType alpha, phi, theta;
-    sure::descriptor::calculateSurfletPairRelations(position_, normal_.vector(), currNode->fixed().getMeanPosition(), payload->normal_.vector(), alpha, phi, theta);
-    if( std::isfinite(alpha) && std::isfinite(phi) && std::isfinite(theta) )
-    {
-      unsigned dClass = getDistanceClass(position_, currNode->fixed().getMeanPosition());
-      descriptors_.at(dClass).shape().insertValues(alpha, phi, theta);
-      usedPoints++;
-    }
+    usedPoints += insertShape(nodes[i], normals);
   }
   return usedPoints;
 }
@@ -103,38 +148,17 @@ int sure::feature::Feature::createColordescriptor(const NodeVector& nodes)
   int usedPoints(0);
   for(unsigned i=0; i<nodes.size(); ++i)
   {
-    Node* currNode = nodes[i];
-    Scalar hue, saturation, lightness;
-    sure::descriptor::convertRGBtoHSL(currNode->fixed().getMeanColor()[0], currNode->fixed().getMeanColor()[1], currNode->fixed().getMeanColor()[2], hue, saturation, lightness);
-    if( std::isfinite(hue) && std::isfinite(saturation) )
-    {
-      unsigned dClass = getDistanceClass(position_, currNode->fixed().getMeanPosition());
-      descriptors_.at(dClass).color().insertValue(hue, saturation);
-      usedPoints++;
-    }
+    usedPoints += insertColor(nodes[i]);
   }
   return usedPoints;
 }
 
-int sure::feature::Feature::createLightnessdescriptor(const NodeVector& nodes, Scalar referenceLightness)
+int sure::feature::Feature::createLightnessdescriptor(const NodeVector& nodes)
 {
-  for(unsigned i=0; i<descriptors_.size(); ++i)
-  {
-    descriptors_[i].lightness().setLightness(referenceLightness);
-  }
-
   int usedPoints(0);
   for(unsigned i=0; i<nodes.size(); ++i)
   {
-    Node* currNode = nodes[i];
-    Scalar hue, saturation, lightness;
-    sure::descriptor::convertRGBtoHSL(currNode->fixed().getMeanColor()[0], currNode->fixed().getMeanColor()[1], currNode->fixed().getMeanColor()[2], hue, saturation, lightness);
-    if( std::isfinite(hue) && std::isfinite(saturation) )
-    {
-      unsigned dClass = getDistanceClass(position_, currNode->fixed().getMeanPosition());
-      descriptors_.at(dClass).lightness().insertValue(lightness);
-      usedPoints++;
-    }
+    usedPoints += insertLightness(nodes[i]);
   }
   return usedPoints;
 }
@@ -33,17 +33,17 @@
 
 #include <sure/feature/feature_extraction.h>
 
-sure::feature::Feature sure::feature::createFeature(const Octree& octree, const Vector3& position, Scalar samplingrate, Scalar radius, const sure::normal::Normal& normal, unsigned distanceClasses)
+sure::feature::Feature sure::feature::createFeature(const Octree& octree, const NormalTable& normals, const Vector3& position, Scalar samplingrate, Scalar radius, const sure::normal::Normal& normal, unsigned distanceClasses)
 {
   Feature feature;
   feature.position() = position;
   feature.radius() = radius;
   feature.normal() = normal;
-  createDescriptor(octree, feature, samplingrate, distanceClasses);
+  createDescriptor(octree, normals, feature, samplingrate, distanceClasses);
   return feature;
 }
 
-sure::feature::Feature sure::feature::createFeature(const Octree& octree, const Vector3& position, Scalar samplingrate, Scalar radius, const Vector3& viewPoint, unsigned distanceClasses)
+sure::feature::Feature sure::feature::createFeature(const Octree& octree, const NormalTable& normals, const Vector3& position, Scalar samplingrate, Scalar radius, const Vector3& viewPoint, unsigned distanceClasses)
 {
   Feature feature;
   feature.position() = position;
@@ -51,22 +51,31 @@ sure::feature::Feature sure::feature::createFeature(const Octree& octree, const
   if( sure::normal::estimateNormal(octree, position, radius, feature.normal()) )
   {
     sure::normal::orientateNormal(position, feature.normal(), viewPoint);
-    createDescriptor(octree, feature, samplingrate, distanceClasses);
+    createDescriptor(octree, normals, feature, samplingrate, distanceClasses);
   }
   return feature;
 }
 
-unsigned sure::feature::createDescriptors(const Octree& octree, std::vector<Feature>& features, Scalar samplingrate, const Vector3& viewPoint, unsigned distanceClasses)
+unsigned sure::feature::createDescriptors(const Octree& octree, const NormalTable& normals, std::vector<Feature>& features, Scalar samplingrate, const Vector3& viewPoint, unsigned distanceClasses, int threads)
 {
   unsigned sum(0);
-  for(unsigned featureIndex=0; featureIndex<features.size(); ++featureIndex)
+  const int size = features.size();
+  threads = sure::getNumberOfThreads(threads);
+
+  // builds the summed-volume table used by estimateNormal, if enabled, before the features are processed concurrently
+  octree.getSummedVolumeTable(octree.getMaximumDepth());
+
+  // every feature only reads the octree and writes its own descriptor, so they are identical to the serial results.
+  // All intermediate data (integrated payload, visitor state) lives on the stack of the working thread
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads) reduction(+:sum)
+  for(int featureIndex=0; featureIndex<size; ++featureIndex)
   {
     Feature& currFeature = features[featureIndex];
 
     if( sure::normal::estimateNormal(octree, currFeature.position(), currFeature.radius(), currFeature.normal()) )
     {
       sure::normal::orientateNormal(currFeature.position(), currFeature.normal(), viewPoint);
-      if( createDescriptor(octree, currFeature, samplingrate, distanceClasses) )
+      if( createDescriptor(octree, normals, currFeature, samplingrate, distanceClasses) )
       {
         sum++;
       }
@@ -75,18 +84,19 @@ unsigned sure::feature::createDescriptors(const Octree& octree, std::vector<Feat
   return sum;
 }
 
-bool sure::feature::createDescriptor(const Octree& octree, Feature& feature, Scalar samplingrate, unsigned distanceClasses)
+bool sure::feature::createDescriptor(const Octree& octree, const NormalTable& normals, Feature& feature, Scalar samplingrate, unsigned distanceClasses)
 {
   Scalar hue, saturation, lightness;
-  sure::payload::PointsRGB regionIntegrate;
+  FixedPayload regionIntegrate;
   octree.integratePayload(feature.position(), feature.radius(), regionIntegrate);
 
   sure::descriptor::convertRGBtoHSL(regionIntegrate.red(), regionIntegrate.green(), regionIntegrate.blue(), hue, saturation, lightness);
 
-  NodeVector vec = octree.getNodes(feature.position(), feature.radius(), samplingrate);
-  unsigned usedPoints(0), usedColors(0), usedLightness(0);
-
-  feature.createDescriptor(vec, lightness, distanceClasses);
+  feature.prepareDescriptor(lightness, distanceClasses);
+  // the shape descriptor needs the normals of the visited depth
+  DescriptorInserter inserter(feature, normals.contains(octree.getDepth(samplingrate)) ? &normals : NULL);
+  octree.forEachNodeIn(feature.position(), feature.radius(), samplingrate, inserter);
+  feature.finishDescriptor();
 
   return feature.hasDescriptor();
 }
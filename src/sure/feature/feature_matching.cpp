@@ -0,0 +1,293 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sure/feature/feature_matching.h>
+
+#include <limits>
+#include <algorithm>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SURE_X86_DISTANCE_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+  typedef sure::feature::PackedDescriptors PackedDescriptors;
+
+  const unsigned LANES = PackedDescriptors::LANES;
+  const unsigned BINS = PackedDescriptors::BINS;
+  const unsigned SHAPE_SIZE = sure::descriptor::SHAPE_DESCRIPTOR_SIZE;
+
+  //! First bin of the alpha, phi, theta and lightness histogram, followed by the end of the last one
+  const unsigned HISTOGRAM_BEGIN[5] = { 0, SHAPE_SIZE, 2*SHAPE_SIZE, 3*SHAPE_SIZE, BINS };
+
+  template <int SizeT>
+  void interleave(const sure::descriptor::Histogram<SizeT>& histogram, unsigned index, unsigned lane, float* block)
+  {
+    for(int i=0; i<SizeT; ++i)
+    {
+      block[(HISTOGRAM_BEGIN[index] + i) * LANES + lane] = histogram[i];
+    }
+    block[(BINS + index) * LANES + lane] = histogram.weight();
+  }
+
+  // All kernels compute the squared differences in single precision and sum them up bin by bin in double precision,
+  // as Histogram::L2Distance does, so they give the same results
+
+  //! Sums up the squared differences between the bins of a single descriptor and every lane of a block, for all four histograms
+  void scalarLaneSums(const float* row, const float* block, double* sums)
+  {
+    for(unsigned h=0; h<4; ++h)
+    {
+      for(unsigned lane=0; lane<LANES; ++lane)
+      {
+        double sum(0.0);
+        for(unsigned k=HISTOGRAM_BEGIN[h]; k<HISTOGRAM_BEGIN[h+1]; ++k)
+        {
+          const float difference = block[k * LANES + lane] - row[k];
+          sum += difference * difference;
+        }
+        sums[h * LANES + lane] = sum;
+      }
+    }
+  }
+
+#ifdef SURE_X86_DISTANCE_KERNELS
+
+  __attribute__((target("sse2")))
+  void sseLaneSums(const float* row, const float* block, double* sums)
+  {
+    for(unsigned h=0; h<4; ++h)
+    {
+      __m128d sum0 = _mm_setzero_pd(), sum1 = _mm_setzero_pd(), sum2 = _mm_setzero_pd(), sum3 = _mm_setzero_pd();
+      for(unsigned k=HISTOGRAM_BEGIN[h]; k<HISTOGRAM_BEGIN[h+1]; ++k)
+      {
+        const __m128 value = _mm_set1_ps(row[k]);
+        __m128 difference = _mm_sub_ps(_mm_load_ps(block + k * LANES), value);
+        __m128 squared = _mm_mul_ps(difference, difference);
+        sum0 = _mm_add_pd(sum0, _mm_cvtps_pd(squared));
+        sum1 = _mm_add_pd(sum1, _mm_cvtps_pd(_mm_movehl_ps(squared, squared)));
+        difference = _mm_sub_ps(_mm_load_ps(block + k * LANES + 4), value);
+        squared = _mm_mul_ps(difference, difference);
+        sum2 = _mm_add_pd(sum2, _mm_cvtps_pd(squared));
+        sum3 = _mm_add_pd(sum3, _mm_cvtps_pd(_mm_movehl_ps(squared, squared)));
+      }
+      _mm_storeu_pd(sums + h * LANES, sum0);
+      _mm_storeu_pd(sums + h * LANES + 2, sum1);
+      _mm_storeu_pd(sums + h * LANES + 4, sum2);
+      _mm_storeu_pd(sums + h * LANES + 6, sum3);
+    }
+  }
+
+  __attribute__((target("avx")))
+  void avxLaneSums(const float* row, const float* block, double* sums)
+  {
+    for(unsigned h=0; h<4; ++h)
+    {
+      __m256d sumLow = _mm256_setzero_pd(), sumHigh = _mm256_setzero_pd();
+      for(unsigned k=HISTOGRAM_BEGIN[h]; k<HISTOGRAM_BEGIN[h+1]; ++k)
+      {
+        const __m256 difference = _mm256_sub_ps(_mm256_loadu_ps(block + k * LANES), _mm256_set1_ps(row[k]));
+        const __m256 squared = _mm256_mul_ps(difference, difference);
+        sumLow = _mm256_add_pd(sumLow, _mm256_cvtps_pd(_mm256_castps256_ps128(squared)));
+        sumHigh = _mm256_add_pd(sumHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(squared, 1)));
+      }
+      _mm256_storeu_pd(sums + h * LANES, sumLow);
+      _mm256_storeu_pd(sums + h * LANES + 4, sumHigh);
+    }
+  }
+
+#endif
+
+  typedef void (*LaneSumKernel)(const float* row, const float* block, double* sums);
+
+  LaneSumKernel getFastestLaneSumKernel()
+  {
+#ifdef SURE_X86_DISTANCE_KERNELS
+    __builtin_cpu_init();
+    if( __builtin_cpu_supports("avx") )
+    {
+      return avxLaneSums;
+    }
+    if( __builtin_cpu_supports("sse2") )
+    {
+      return sseLaneSums;
+    }
+#endif
+    return scalarLaneSums;
+  }
+
+  //! Same as Histogram::L2Distance for a precomputed sum of squared differences
+  inline sure::Scalar l2Distance(double sum, float lhsWeight, float rhsWeight)
+  {
+    if( lhsWeight > 0.0 || rhsWeight > 0.0 )
+    {
+      return sqrt(sum) / (lhsWeight + rhsWeight);
+    }
+    return std::numeric_limits<sure::Scalar>::infinity();
+  }
+
+}
+
+void sure::feature::PackedDescriptors::pack(const std::vector<Feature>& features)
+{
+  size_ = features.size();
+  classes_ = 0;
+  for(unsigned i=0; i<size_; ++i)
+  {
+    classes_ = std::max(classes_, features[i].numberOfDescriptors());
+  }
+  const unsigned blocks = (size_ + LANES - 1) / LANES;
+  histograms_.assign(blocks * classes_ * BLOCK_SIZE, 0.f);
+  colors_.assign(size_ * classes_ * sure::descriptor::COLOR_DISTANCE_VECTOR_SIZE, 0.0);
+  descriptors_.resize(size_);
+  radii_.resize(size_);
+
+  for(unsigned i=0; i<size_; ++i)
+  {
+    const Feature& feature = features[i];
+    descriptors_[i] = feature.numberOfDescriptors();
+    radii_[i] = feature.radius();
+    for(unsigned c=0; c<descriptors_[i]; ++c)
+    {
+      const Descriptor& descriptor = feature.descriptor(c);
+      float* block = &histograms_[((i / LANES) * classes_ + c) * BLOCK_SIZE];
+      interleave(descriptor.shape().alpha(), 0, i % LANES, block);
+      interleave(descriptor.shape().phi(), 1, i % LANES, block);
+      interleave(descriptor.shape().theta(), 2, i % LANES, block);
+      interleave(descriptor.lightness(), 3, i % LANES, block);
+      descriptor.color().getDistanceVector(&colors_[(i * classes_ + c) * sure::descriptor::COLOR_DISTANCE_VECTOR_SIZE]);
+    }
+  }
+}
+
+void sure::feature::calculateDistanceMatrix(const PackedDescriptors& rows, const PackedDescriptors& columns, std::vector<Scalar>& distances,
+    Scalar shapeWeight, Scalar colorWeight, Scalar lightnessWeight, int threads)
+{
+  static const LaneSumKernel laneSums = getFastestLaneSumKernel();
+  const int numberOfRows = rows.size();
+  const unsigned numberOfColumns = columns.size();
+  const Scalar weightSum = shapeWeight + colorWeight + lightnessWeight;
+  distances.resize((std::size_t) numberOfRows * numberOfColumns);
+  threads = sure::getNumberOfThreads(threads);
+
+#pragma omp parallel num_threads(threads)
+  {
+    // scratch buffers of a single thread
+    float row[BINS], rowWeights[4];
+    double sums[4 * LANES];
+    Scalar laneDistances[LANES];
+    bool valid[LANES];
+
+#pragma omp for schedule(dynamic, 16)
+    for(int i=0; i<numberOfRows; ++i)
+    {
+      const unsigned rowLane = i % LANES;
+      const unsigned classes = rows.numberOfDescriptors(i);
+      Scalar* rowDistances = &distances[(std::size_t) i * numberOfColumns];
+
+      for(unsigned blockBegin=0; blockBegin<numberOfColumns; blockBegin+=LANES)
+      {
+        const unsigned lanes = std::min(LANES, numberOfColumns - blockBegin);
+        bool anyValid(false);
+        for(unsigned lane=0; lane<lanes; ++lane)
+        {
+          const unsigned j = blockBegin + lane;
+          valid[lane] = classes == columns.numberOfDescriptors(j) && !(fabs(rows.radius(i) - columns.radius(j)) > 1e-3);
+          laneDistances[lane] = valid[lane] ? 0.0 : std::numeric_limits<Scalar>::infinity();
+          anyValid |= valid[lane];
+        }
+
+        for(unsigned c=0; anyValid && c<classes; ++c)
+        {
+          const float* rowBlock = rows.block(i, c);
+          for(unsigned k=0; k<BINS; ++k)
+          {
+            row[k] = rowBlock[k * LANES + rowLane];
+          }
+          for(unsigned h=0; h<4; ++h)
+          {
+            rowWeights[h] = rowBlock[(BINS + h) * LANES + rowLane];
+          }
+          const float* columnBlock = columns.block(blockBegin, c);
+          laneSums(row, columnBlock, sums);
+          const double* rowColor = rows.color(i, c);
+
+          for(unsigned lane=0; lane<lanes; ++lane)
+          {
+            if( !valid[lane] )
+            {
+              continue;
+            }
+            // same order of operations as Descriptor::distanceTo and ShapeDescriptor::distanceTo
+            Scalar shape(0.0);
+            for(unsigned h=0; h<3; ++h)
+            {
+              shape += l2Distance(sums[h * LANES + lane], rowWeights[h], columnBlock[(BINS + h) * LANES + lane]);
+            }
+            shape /= 3.0;
+            const Scalar lightness = l2Distance(sums[3 * LANES + lane], rowWeights[3], columnBlock[(BINS + 3) * LANES + lane]);
+
+            Scalar distance(0.0);
+            distance += shape * shapeWeight;
+            if( colorWeight != 0.0 )
+            {
+              distance += sure::descriptor::ColorDescriptor::distance(rowColor, columns.color(blockBegin + lane, c)) * colorWeight;
+            }
+            distance += lightness * lightnessWeight;
+            laneDistances[lane] += distance / weightSum;
+          }
+        }
+
+        for(unsigned lane=0; lane<lanes; ++lane)
+        {
+          rowDistances[blockBegin + lane] = valid[lane] ? laneDistances[lane] / (Scalar) classes : laneDistances[lane];
+        }
+      }
+    }
+  }
+}
+
+void sure::feature::calculateDistanceMatrix(const std::vector<Feature>& rows, const std::vector<Feature>& columns, std::vector<Scalar>& distances,
+    Scalar shapeWeight, Scalar colorWeight, Scalar lightnessWeight, int threads)
+{
+  PackedDescriptors packedRows(rows), packedColumns(columns);
+  calculateDistanceMatrix(packedRows, packedColumns, distances, shapeWeight, colorWeight, lightnessWeight, threads);
+}
@@ -31,38 +31,106 @@
 // ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+
 #include <sure/keypoints/keypoint_calculation.h>
 
-void sure::keypoints::allocateEntropyPayload(Octree& octree, Scalar samplingrate, sure::memory::FixedSizeAllocatorWithDirectAccess<EntropyPayload>& allocator)
+namespace
 {
-  unsigned depth = octree.getDepth(samplingrate);
-  allocator.resizeIfSmaller(octree[depth].size());
-  for(unsigned int i=0; i<octree[depth].size(); ++i)
+
+  //! Cell of the grid used for finding redundant keypoints
+  struct GridCell
   {
-    Node* node = octree[depth][i];
-    EntropyPayload* payload = allocator.allocate(i);
-    node->setOptionalPayload(static_cast<sure::payload::Payload*>(payload));
+      GridCell() : x_(0), y_(0), z_(0) { }
+      GridCell(int x, int y, int z) : x_(x), y_(y), z_(z) { }
+
+      bool operator==(const GridCell& rhs) const { return x_ == rhs.x_ && y_ == rhs.y_ && z_ == rhs.z_; }
+
+      //! Spatial hash with large primes
+      unsigned hash() const { return ((unsigned) x_ * 73856093u) ^ ((unsigned) y_ * 19349663u) ^ ((unsigned) z_ * 83492791u); }
+
+      int x_, y_, z_;
+  };
+
+  //! Neighborhood of a node queried from the octree
+  struct OctreeNeighborhood
+  {
+      OctreeNeighborhood(const sure::keypoints::Octree& octree, sure::keypoints::Node* node, unsigned unitRadius) : octree_(octree), node_(node), unitRadius_(unitRadius) { }
+
+      template <typename VisitorT>
+      bool forEach(VisitorT& f) const { return octree_.forEachNodeIn(node_, unitRadius_, node_->depth(), f); }
+
+      const sure::keypoints::Octree& octree_;
+      sure::keypoints::Node* node_;
+      unsigned unitRadius_;
+  };
+
+  //! Neighborhood of a node taken from a neighborhood cache
+  struct CachedNeighborhood
+  {
+      CachedNeighborhood(const sure::keypoints::NeighborhoodCache& neighborhoods, unsigned index) : neighborhoods_(neighborhoods), index_(index) { }
+
+      template <typename VisitorT>
+      bool forEach(VisitorT& f) const { return neighborhoods_.forEachNeighbor(index_, f); }
+
+      const sure::keypoints::NeighborhoodCache& neighborhoods_;
+      unsigned index_;
+  };
+
+  //! Calculates the cornerness from the weighted covariance of the node positions in a neighborhood
+  template <typename NeighborhoodT>
+  sure::Scalar calculateCornerness(const NeighborhoodT& neighborhood, const sure::keypoints::EntropyTable& entropy)
+  {
+    sure::keypoints::WeightedMeanAccumulator meanAccumulator(entropy);
+    neighborhood.forEach(meanAccumulator);
+
+    sure::Vector3 mean(meanAccumulator.mean_);
+    sure::Scalar weight(meanAccumulator.weight_);
+    if( weight > 0.0 )
+    {
+      mean /= weight;
+    }
+    else
+    {
+      return 0.f;
+    }
+
+    sure::keypoints::WeightedCovarianceAccumulator covarianceAccumulator(entropy, mean);
+    neighborhood.forEach(covarianceAccumulator);
+    sure::Matrix3 covariance(covarianceAccumulator.covariance_);
+    covariance /= weight;
+
+    sure::Vector3 eigenValues;
+    pcl::eigen33(covariance, eigenValues);
+
+    return (sure::Scalar) (eigenValues[0] / eigenValues[2]);
   }
+
 }
 
-void sure::keypoints::flagArtificialPoints(Octree& octree, Scalar samplingrate)
+void sure::keypoints::allocateEntropyPayload(Octree& octree, Scalar samplingrate, EntropyTable& entropy)
+{
+  unsigned depth = octree.getDepth(samplingrate);
+  entropy.reset(depth, octree[depth].size());
+}
+
+void sure::keypoints::flagArtificialPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate)
 {
   unsigned depth = octree.getDepth(samplingrate);
 
   for(unsigned int i=0; i<octree[depth].size(); ++i)
   {
     Node* node = octree[depth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(node->opt());
 
     if( node->fixed().getPointFlag() == ARTIFICIAL )
     {
-      payload->flag_ = ARTIFICIAL_POINTS;
+      entropy.flags_[i] = ARTIFICIAL_POINTS;
       continue;
     }
   }
 }
 
-void sure::keypoints::flagDistantPoints(Octree& octree, Scalar samplingrate, Scalar threshold, const Vector3& sensorPosition)
+void sure::keypoints::flagDistantPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate, Scalar threshold, const Vector3& sensorPosition)
 {
   unsigned depth = octree.getDepth(samplingrate);
   threshold *= threshold;
@@ -70,60 +138,65 @@ void sure::keypoints::flagDistantPoints(Octree& octree, Scalar samplingrate, Sca
   for(unsigned int i=0; i<octree[depth].size(); ++i)
   {
     Node* node = octree[depth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(node->opt());
 
     if( (node->fixed().getMeanPosition() - sensorPosition).squaredNorm() > threshold )
     {
-      payload->flag_ = DISTANCE_TOO_HIGH;
+      entropy.flags_[i] = DISTANCE_TOO_HIGH;
       continue;
     }
   }
 }
 
-void sure::keypoints::flagBackgroundPoints(Octree& octree, Scalar samplingrate)
+void sure::keypoints::flagBackgroundPoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate)
 {
   unsigned depth = octree.getDepth(samplingrate);
 
   for(unsigned int i=0; i<octree[depth].size(); ++i)
   {
     Node* node = octree[depth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(node->opt());
 
     if( ((node->fixed().getPointFlag() & BACKGROUND_BORDER) == BACKGROUND_BORDER) )
     {
-      payload->flag_ = BACKGROUND_EDGE;
+      entropy.flags_[i] = BACKGROUND_EDGE;
       continue;
     }
   }
 }
 
-void sure::keypoints::resetFeatureFlags(Octree& octree, Scalar samplingrate)
+void sure::keypoints::resetFeatureFlags(Octree& octree, EntropyTable& entropy, Scalar samplingrate)
 {
   unsigned depth = octree.getDepth(samplingrate);
 
   for(unsigned int i=0; i<octree[depth].size(); ++i)
   {
-    Node* node = octree[depth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(node->opt());
-
-    if( payload->flag_ < DISTANCE_TOO_HIGH )
+    if( entropy.flags_[i] < DISTANCE_TOO_HIGH )
     {
-      payload->flag_ = NOT_CALCULATED;
+      entropy.flags_[i] = NOT_CALCULATED;
     }
   }
 }
 
 
-void sure::keypoints::calculateEntropy(Octree& octree, Scalar samplingrate, Scalar normalSamplingrate, Scalar radius, Scalar threshold, EntropyCalculationMode mode, Scalar influenceRadius)
+void sure::keypoints::calculateEntropy(Octree& octree, const NormalTable& normals, EntropyTable& entropy, Scalar samplingrate, Scalar normalSamplingrate, Scalar radius, Scalar threshold, EntropyCalculationMode mode, Scalar influenceRadius, int threads, bool approximateEntropy)
 {
   unsigned samplingDepth = octree.getDepth(samplingrate);
+  const NodeVector& nodes = octree[samplingDepth];
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
 
-  for(unsigned int i=0; i<octree[samplingDepth].size(); ++i)
+  // builds the summed-volume table used for the main normal, if enabled, before the nodes are processed concurrently
+  if( mode == CROSS_PRODUCTS_W_MAIN )
   {
-    Node* node = octree[samplingDepth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(node->opt());
+    octree.getSummedVolumeTable(octree.getMaximumDepth());
+  }
 
-    if( payload->flag_ != NOT_CALCULATED )
+  // every node only reads normals and writes its own entropy
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+  for(int i=0; i<size; ++i)
+  {
+    Node* node = nodes[i];
+
+    if( entropy.flags_[i] != NOT_CALCULATED )
     {
       continue;
     }
@@ -132,207 +205,189 @@ void sure::keypoints::calculateEntropy(Octree& octree, Scalar samplingrate, Scal
     {
       default:
       case NORMALS:
-        payload->entropy_ = calculateEntropyWithNormals(octree, node, normalSamplingrate, radius, influenceRadius);
+        entropy.entropy_[i] = calculateEntropyWithNormals(octree, normals, node, normalSamplingrate, radius, influenceRadius, approximateEntropy);
         break;
       case CROSS_PRODUCTS_W_MAIN:
-        payload->entropy_ = calculateEntropyWithCrossproducts(octree, node, normalSamplingrate, radius, influenceRadius);
+        entropy.entropy_[i] = calculateEntropyWithCrossproducts(octree, normals, node, normalSamplingrate, radius, influenceRadius, approximateEntropy);
         break;
       case CROSS_PRODUCTS_PAIRWISE:
-        payload->entropy_ = calculateEntropyWithCrossproductsPairwise(octree, node, normalSamplingrate, radius, influenceRadius);
+        entropy.entropy_[i] = calculateEntropyWithCrossproductsPairwise(octree, normals, node, normalSamplingrate, radius, influenceRadius, approximateEntropy);
         break;
     }
 
-    if( payload->entropy_ < threshold )
+    if( entropy.entropy_[i] < threshold )
     {
-      payload->flag_ = ENTROPY_TOO_LOW;
+      entropy.flags_[i] = ENTROPY_TOO_LOW;
       continue;
     }
-    payload->flag_ = POSSIBLE;
+    entropy.flags_[i] = POSSIBLE;
   }
 }
 
-sure::Scalar sure::keypoints::calculateEntropyWithNormals(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius)
-{
-  NormalPayload regionIntegrate;
-  regionIntegrate.histogram_.setInfluenceRadius(influenceRadius);
-  octree.integrateOptionalPayload<NormalPayload>(node->fixed().getMeanPosition(), radius, normalSamplingrate, regionIntegrate);
-
-  return regionIntegrate.histogram_.calculateEntropy();
-}
-
-sure::Scalar sure::keypoints::calculateEntropyWithCrossproducts(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius)
+void sure::keypoints::calculateEntropy(Octree& octree, const ScaleSpacePyramid& pyramid, EntropyTable& entropy, Scalar samplingrate, Scalar radius, Scalar threshold, int threads, bool approximateEntropy)
 {
-  FixedPayload mainNormalIntegrate;
-  octree.integratePayload(node->fixed().getMeanPosition(), radius, mainNormalIntegrate);
-  Normal mainNormal = mainNormalIntegrate.calculateNormal();
+  unsigned samplingDepth = octree.getDepth(samplingrate);
+  const NodeVector& nodes = octree[samplingDepth];
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
 
-  if( mainNormal.isStable() )
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+  for(int i=0; i<size; ++i)
   {
-    sure::normal::CrossProductHistogram histogram;
-    histogram.setInfluenceRadius(influenceRadius);
-    NodeVector nodes = octree.getNodes(node->fixed().getMeanPosition(), radius, normalSamplingrate);
+    Node* node = nodes[i];
 
-    for(unsigned int i=0; i<nodes.size(); ++i)
+    if( entropy.flags_[i] != NOT_CALCULATED )
     {
-      Node* currNode = nodes[i];
-      NormalPayload* currPayload = static_cast<CrossProductPayload*>(currNode->opt());
-      if( currPayload->normal_.isStable())
-      {
-        histogram.insertCrossProduct(mainNormal.vector(), currPayload->normal_.vector());
-      }
+      continue;
     }
 
-    return histogram.calculateEntropy();
-  }
-  return 0.0;
-}
-
-sure::Scalar sure::keypoints::calculateEntropyWithCrossproductsPairwise(const Octree& octree, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius)
-{
-  sure::normal::CrossProductHistogram histogram;
-  histogram.setInfluenceRadius(influenceRadius);
-  NodeVector nodes = octree.getNodes(node->fixed().getMeanPosition(), radius, normalSamplingrate);
-  for(unsigned int i=0; i<nodes.size(); ++i)
-  {
-    Node* firstNode = nodes[i];
-    NormalPayload* firstPayload = static_cast<NormalPayload*>(firstNode->opt());
-    const Normal& firstNormal = firstPayload->normal_;
+    entropy.entropy_[i] = calculateEntropyWithNormals(pyramid, node, radius, approximateEntropy);
 
-    if( !firstNormal.isStable() )
+    if( entropy.entropy_[i] < threshold )
     {
+      entropy.flags_[i] = ENTROPY_TOO_LOW;
       continue;
     }
-
-    for(unsigned int j=i+1; j<nodes.size(); ++j)
-    {
-      Node* secondNode = nodes[j];
-      CrossProductPayload* secondPayload = static_cast<CrossProductPayload*>(secondNode->opt());
-      const Normal& secondNormal = secondPayload->normal_;
-      if( secondNormal.isStable() )
-      {
-        histogram.insertCrossProduct(firstNormal.vector(), secondNormal.vector());
-      }
-    }
-
-    return histogram.calculateEntropy();
+    entropy.flags_[i] = POSSIBLE;
   }
-  return 0.0;
 }
 
-
-sure::Scalar sure::keypoints::calculateCornerness(const Octree& octree, Node* node, Scalar radius)
+sure::Scalar sure::keypoints::calculateEntropyWithNormals(const ScaleSpacePyramid& pyramid, Node* node, Scalar radius, bool approximateEntropy)
 {
-  Octree::NodeVector vec;
-  vec = octree.getNodes(node, octree.getUnitSize(radius));
+  sure::normal::NormalHistogram histogram;
+  pyramid.integrate(node->fixed().getMeanPosition(), radius, histogram);
+
+  return histogram.calculateEntropy(approximateEntropy);
+}
 
-  Vector3 mean(Vector3::Zero());
-  Scalar weight(0.0);
-  for(unsigned int i=0; i<vec.size(); ++i)
+sure::Scalar sure::keypoints::calculateEntropyWithNormals(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy)
+{
+  if( !normals.contains(octree.getDepth(normalSamplingrate)) )
   {
-    Node* currNode = vec[i];
-    sure::payload::EntropyPayload* payload = static_cast<EntropyPayload*>(currNode->opt());
-    if( payload->entropy_ > 0.0 )
-    {
-      mean += (payload->entropy_ * currNode->fixed().getMeanPosition());
-//      mean[0] += (payload->entropy_ * currNode->fixed().getMeanPosition()[0]);
-//      mean[1] += (payload->entropy_ * currNode->fixed().getMeanPosition()[1]);
-//      mean[2] += (payload->entropy_ * currNode->fixed().getMeanPosition()[2]);
-      weight += payload->entropy_;
-    }
+    return 0.0;
   }
+  sure::normal::NormalHistogram regionIntegrate;
+  regionIntegrate.setInfluenceRadius(influenceRadius);
+  octree.integrateSideTable(node->fixed().getMeanPosition(), radius, normalSamplingrate, normals.histograms_, regionIntegrate);
+
+  return regionIntegrate.calculateEntropy(approximateEntropy);
+}
 
-  if( weight > 0.0 )
+sure::Scalar sure::keypoints::calculateEntropyWithCrossproducts(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy)
+{
+  if( !normals.contains(octree.getDepth(normalSamplingrate)) )
   {
-    mean /= weight;
+    return 0.0;
   }
-  else
+  FixedPayload mainNormalIntegrate;
+  octree.integratePayload(node->fixed().getMeanPosition(), radius, mainNormalIntegrate);
+  Normal mainNormal = mainNormalIntegrate.calculateNormal();
+
+  if( mainNormal.isStable() )
   {
-    return 0.f;
+    sure::normal::CrossProductHistogram histogram;
+    histogram.setInfluenceRadius(influenceRadius);
+    CrossProductInserter inserter(normals, mainNormal.vector(), histogram);
+    octree.forEachNodeIn(node->fixed().getMeanPosition(), radius, normalSamplingrate, inserter);
+
+    return histogram.calculateEntropy(approximateEntropy);
   }
+  return 0.0;
+}
 
-  Matrix3 covariance(Matrix3::Zero());
-  for(unsigned int i=0; i<vec.size(); ++i)
+sure::Scalar sure::keypoints::calculateEntropyWithCrossproductsPairwise(const Octree& octree, const NormalTable& normals, Node* node, Scalar normalSamplingrate, Scalar radius, Scalar influenceRadius, bool approximateEntropy)
+{
+  if( !normals.contains(octree.getDepth(normalSamplingrate)) )
   {
-    Node* currNode = vec[i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(currNode->opt());
+    return 0.0;
+  }
+  sure::normal::CrossProductHistogram histogram;
+  histogram.setInfluenceRadius(influenceRadius);
+  PairwiseCrossProductInserter inserter(normals, histogram);
+  octree.forEachNodeIn(node->fixed().getMeanPosition(), radius, normalSamplingrate, inserter);
 
-    if( payload->entropy_ > 0.0 )
-    {
-//      Vector3 d;
-//      d[0] = mean[0] - currNode->fixed().getMeanPosition()[0];
-//      d[1] = mean[1] - currNode->fixed().getMeanPosition()[1];
-//      d[2] = mean[2] - currNode->fixed().getMeanPosition()[2];
-      covariance += payload->entropy_ * ( (mean - currNode->fixed().getMeanPosition()) * ((mean - currNode->fixed().getMeanPosition()).transpose()) );
-//      covariance += payload->entropy_ * ( d * d.transpose() );
-    }
+  if( inserter.first_ )
+  {
+    return histogram.calculateEntropy(approximateEntropy);
   }
-  covariance /= weight;
+  return 0.0;
+}
 
-  Vector3 eigenValues;
-  pcl::eigen33(covariance, eigenValues);
 
-  return (Scalar) (eigenValues[0] / eigenValues[2]);
+sure::Scalar sure::keypoints::calculateCornerness(const Octree& octree, const EntropyTable& entropy, Node* node, Scalar radius)
+{
+  return calculateCornerness(OctreeNeighborhood(octree, node, octree.getUnitSize(radius)), entropy);
+}
+
+sure::Scalar sure::keypoints::calculateCornerness(const NeighborhoodCache& neighborhoods, const EntropyTable& entropy, unsigned index)
+{
+  return calculateCornerness(CachedNeighborhood(neighborhoods, index), entropy);
 }
 
-void sure::keypoints::calculateCornerness(Octree& octree, Scalar samplingRate, Scalar radius, Scalar threshold)
+void sure::keypoints::calculateCornerness(Octree& octree, EntropyTable& entropy, Scalar samplingRate, Scalar radius, Scalar threshold, int threads, const NeighborhoodCache* neighborhoods)
 {
   unsigned samplingDepth = octree.getDepth(samplingRate);
+  const NodeVector& nodes = octree[samplingDepth];
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
+  if( neighborhoods && !neighborhoods->contains(octree, samplingDepth, octree.getUnitSize(radius)) )
+  {
+    neighborhoods = NULL;
+  }
 
-  for(unsigned int i=0; i<octree[samplingDepth].size(); ++i)
+  // every node only reads the entropy of its neighbors and writes its own cornerness and flag
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads)
+  for(int i=0; i<size; ++i)
   {
-    Node* currNode = octree[samplingDepth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(currNode->opt());
+    Node* currNode = nodes[i];
 
-    if( payload->flag_ == POSSIBLE )
+    if( entropy.flags_[i] == POSSIBLE )
     {
-      payload->cornerness_ = sure::keypoints::calculateCornerness(octree, currNode, radius);
-      if( payload->cornerness_ < threshold )
+      if( neighborhoods )
+      {
+        entropy.cornerness_[i] = sure::keypoints::calculateCornerness(*neighborhoods, entropy, i);
+      }
+      else
       {
-        payload->flag_ = CORNERNESS_TOO_LOW;
+        entropy.cornerness_[i] = sure::keypoints::calculateCornerness(octree, entropy, currNode, radius);
+      }
+      if( entropy.cornerness_[i] < threshold )
+      {
+        entropy.flags_[i] = CORNERNESS_TOO_LOW;
       }
     }
   }
 }
 
-unsigned sure::keypoints::extractKeypoints(Octree& octree, Scalar samplingrate, Scalar searchRadius, Scalar featureRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes)
+unsigned sure::keypoints::extractKeypoints(Octree& octree, EntropyTable& entropy, Scalar samplingrate, Scalar searchRadius, Scalar featureRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes, const NeighborhoodCache* neighborhoods)
 {
   unsigned samplingDepth = octree.getDepth(samplingrate);
+  unsigned unitRadius = octree.getUnitSize(searchRadius);
   unsigned keypoints(0);
+  if( neighborhoods && !neighborhoods->contains(octree, samplingDepth, unitRadius) )
+  {
+    neighborhoods = NULL;
+  }
 
   for(unsigned int i=0; i<octree[samplingDepth].size(); ++i)
   {
     Node* currNode = octree[samplingDepth][i];
-    EntropyPayload* payload = static_cast<EntropyPayload*>(currNode->opt());
-    if( payload->flag_ != POSSIBLE )
+    if( entropy.flags_[i] != POSSIBLE )
     {
       continue;
     }
-    NodeVector neighbors = octree.getNodes(currNode, octree.getUnitSize(searchRadius));
-    for(unsigned int j=0; j<neighbors.size(); ++j)
+    MaximumSuppressor suppressor(entropy, i);
+    if( neighborhoods )
     {
-      Node* currNeighbor = neighbors[j];
-      EntropyPayload* neighborPayload = static_cast<EntropyPayload*>(currNeighbor->opt());
-      if( neighborPayload->flag_ == IS_MAXIMUM )
-      {
-        payload->flag_ = SUPPRESSED;
-        break;
-      }
-      else if( neighborPayload->flag_ == POSSIBLE )
-      {
-        if( payload->entropy_ < neighborPayload->entropy_ )
-        {
-          payload->flag_ = SUPPRESSED;
-          break;
-        }
-      }
-      else
-      {
-        continue;
-      }
+      neighborhoods->forEachNeighbor(i, suppressor);
+    }
+    else
+    {
+      octree.forEachNodeIn(currNode, unitRadius, samplingDepth, suppressor);
     }
-    if( payload->flag_ == POSSIBLE )
+    if( entropy.flags_[i] == POSSIBLE )
     {
-      payload->flag_ = IS_MAXIMUM;
+      entropy.flags_[i] = IS_MAXIMUM;
       sure::feature::Feature f;
 
       f.radius() = featureRadius;
@@ -346,61 +401,46 @@ unsigned sure::keypoints::extractKeypoints(Octree& octree, Scalar samplingrate,
 }
 
 
-void sure::keypoints::improveLocalization(const Octree& octree, Scalar samplingrate, Scalar radius, Vector3& position)
+void sure::keypoints::improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, Vector3& position)
+{
+  NodeVector neighborhood;
+  improveLocalization(octree, entropy, samplingrate, radius, position, neighborhood);
+}
+
+void sure::keypoints::improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, Vector3& position, NodeVector& neighborhood)
 {
   for(unsigned iteration=0; iteration<NUMBER_OF_MEAN_SHIFT_ITERATIONS; ++iteration)
   {
-    NodeVector neighbors = octree.getNodes(position, radius, samplingrate);
+    neighborhood.clear();
+    NeighborCollector collector(neighborhood);
+    octree.forEachNodeIn(position, radius, samplingrate, collector);
 
-    Scalar summedMean(0.0);
-    int count(0);
-
-    for(unsigned int n=0; n<neighbors.size(); ++n)
+    EntropyMeanAccumulator meanAccumulator(entropy);
+    for(unsigned i=0; i<neighborhood.size(); ++i)
     {
-      Node* neighbor = neighbors[n];
-      EntropyPayload* neighborPayload = static_cast<EntropyPayload*>(neighbor->opt());
-      if( neighbor->fixed().getPointFlag() != ARTIFICIAL )
-      {
-        summedMean += neighborPayload->entropy_;
-        count++;
-      }
+      meanAccumulator(neighborhood[i]);
     }
 
-    if( count == 0 )
+    if( meanAccumulator.count_ == 0 )
     {
       break;
     }
 
-    Scalar mean = summedMean / (Scalar) count;
-    Scalar summedVariance(0.0);
-    for(unsigned int n=0; n<neighbors.size(); ++n)
+    Scalar mean = meanAccumulator.summedMean_ / (Scalar) meanAccumulator.count_;
+    EntropyVarianceAccumulator varianceAccumulator(entropy, mean);
+    for(unsigned i=0; i<neighborhood.size(); ++i)
     {
-      Node* neighbor = neighbors[n];
-      EntropyPayload* neighborPayload = static_cast<EntropyPayload*>(neighbor->opt());
-      if( neighbor->fixed().getPointFlag() != ARTIFICIAL )
-      {
-        summedVariance += (neighborPayload->entropy_ - mean) * (neighborPayload->entropy_ - mean);
-      }
+      varianceAccumulator(neighborhood[i]);
     }
 
-
-    Scalar variance = summedVariance / (Scalar) count;
-    Vector3 shiftedPosition(0.0, 0.0, 0.0);
-    Scalar summedShift(0.0);
-
-    for(unsigned int n=0; n<neighbors.size(); ++n)
+    Scalar variance = varianceAccumulator.summedVariance_ / (Scalar) meanAccumulator.count_;
+    MeanShiftAccumulator shiftAccumulator(entropy, mean, variance);
+    for(unsigned i=0; i<neighborhood.size(); ++i)
     {
-      Node* neighbor = neighbors[n];
-      EntropyPayload* neighborPayload = static_cast<EntropyPayload*>(neighbor->opt());
-
-      if( neighborPayload->entropy_ > mean )
-      {
-        Scalar entropyDifference = mean - neighborPayload->entropy_;
-        Scalar kernelElements = (entropyDifference*entropyDifference) / (variance);
-        shiftedPosition += neighbor->fixed().getMeanPosition() * exp(-0.5*kernelElements);
-        summedShift += exp(-0.5*kernelElements);
-      }
+      shiftAccumulator(neighborhood[i]);
     }
+    Vector3 shiftedPosition(shiftAccumulator.shiftedPosition_);
+    Scalar summedShift(shiftAccumulator.summedShift_);
     if( summedShift != 0 )
     {
       shiftedPosition = shiftedPosition * (1.f / summedShift);
@@ -413,71 +453,105 @@ void sure::keypoints::improveLocalization(const Octree& octree, Scalar samplingr
   }
 }
 
-void sure::keypoints::improveLocalization(const Octree& octree, Scalar samplingrate, Scalar radius, std::vector<sure::feature::Feature>& features)
+void sure::keypoints::improveLocalization(const Octree& octree, const EntropyTable& entropy, Scalar samplingrate, Scalar radius, std::vector<sure::feature::Feature>& features)
 {
+  NodeVector neighborhood;
   for(std::vector<sure::feature::Feature>::iterator it=features.begin(); it!=features.end(); ++it)
   {
-    sure::keypoints::improveLocalization(octree, samplingrate, radius, (*it).position());
+    sure::keypoints::improveLocalization(octree, entropy, samplingrate, radius, (*it).position(), neighborhood);
   }
 }
 
 
-int sure::keypoints::removeRedundantKeypoints(Scalar searchRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes)
+int sure::keypoints::removeRedundantKeypoints(EntropyTable& entropy, Scalar searchRadius, std::vector<Feature>& features, std::vector<Node*>& keypointNodes)
 {
-  std::vector<bool> keypointStable(features.size(), true);
-  Scalar radiusSquared = (searchRadius) * (searchRadius);
-  for(unsigned firstIndex=0; firstIndex<features.size(); ++firstIndex)
-  {
-    std::deque<unsigned> conflicts;
-    const Feature& firstKeypoint = features[firstIndex];
-    const Vector3& firstPosition = firstKeypoint.position();
+  const int size = features.size();
+  std::vector<bool> keypointStable(size, true);
 
-    for(unsigned secondIndex=firstIndex+1; secondIndex<features.size(); ++secondIndex)
+  if( searchRadius > 0.0 && size > 1 )
+  {
+    // buckets the keypoints in a hashed grid with the search radius as cell size, so only the 27 surrounding cells need to be searched
+    const Scalar cellFactor = 1.0 / searchRadius;
+    std::vector<GridCell> cells(size);
+    unsigned tableSize(1);
+    while( tableSize < (unsigned) size * 2 )
     {
-      const Feature& secondKeypoint = features[secondIndex];
-      const Vector3& secondPosition = secondKeypoint.position();
-      if( (firstPosition - secondPosition).squaredNorm() < radiusSquared )
-      {
-        conflicts.push_back(secondIndex);
-      }
+      tableSize <<= 1;
+    }
+    std::vector<int> bucketBegin(tableSize, -1);
+    std::vector<int> nextInBucket(size, -1);
+    for(int i=size-1; i>=0; --i)
+    {
+      const Vector3& position = features[i].position();
+      cells[i] = GridCell((int) floor(position[0] * cellFactor), (int) floor(position[1] * cellFactor), (int) floor(position[2] * cellFactor));
+      unsigned bucket = cells[i].hash() & (tableSize-1);
+      nextInBucket[i] = bucketBegin[bucket];
+      bucketBegin[bucket] = i;
     }
 
-    unsigned bestKeypoint = firstIndex;
-    Scalar bestEntropy = static_cast<EntropyPayload*>(keypointNodes[firstIndex]->opt())->entropy_;
-
-    for(unsigned j=0; j<conflicts.size(); ++j)
+    Scalar radiusSquared = (searchRadius) * (searchRadius);
+    std::vector<int> conflicts;
+    for(int firstIndex=0; firstIndex<size; ++firstIndex)
     {
-      const unsigned& secondIndex = conflicts[j];
-      const Feature& secondKeypoint = features[secondIndex];
-      Scalar secondEntropy = static_cast<EntropyPayload*>(keypointNodes[secondIndex]->opt())->entropy_;
-      if( secondEntropy > bestEntropy )
+      const Vector3& firstPosition = features[firstIndex].position();
+      const GridCell& firstCell = cells[firstIndex];
+
+      // all later keypoints within the search radius, in the order the all-pairs search would find them
+      conflicts.clear();
+      for(int dx=-1; dx<=1; ++dx)
       {
-        keypointStable[bestKeypoint] = false;
-        bestKeypoint = secondIndex;
-        bestEntropy = secondEntropy;
-        break;
+        for(int dy=-1; dy<=1; ++dy)
+        {
+          for(int dz=-1; dz<=1; ++dz)
+          {
+            GridCell cell(firstCell.x_+dx, firstCell.y_+dy, firstCell.z_+dz);
+            for(int secondIndex=bucketBegin[cell.hash() & (tableSize-1)]; secondIndex>=0; secondIndex=nextInBucket[secondIndex])
+            {
+              if( secondIndex > firstIndex && cells[secondIndex] == cell && (firstPosition - features[secondIndex].position()).squaredNorm() < radiusSquared )
+              {
+                conflicts.push_back(secondIndex);
+              }
+            }
+          }
+        }
       }
-      else
+      std::sort(conflicts.begin(), conflicts.end());
+
+      Scalar bestEntropy = entropy.entropy_[keypointNodes[firstIndex]->index()];
+      for(unsigned j=0; j<conflicts.size(); ++j)
       {
-        keypointStable[secondIndex] = false;
+        const int& secondIndex = conflicts[j];
+        Scalar secondEntropy = entropy.entropy_[keypointNodes[secondIndex]->index()];
+        if( secondEntropy > bestEntropy )
+        {
+          keypointStable[firstIndex] = false;
+          break;
+        }
+        else
+        {
+          keypointStable[secondIndex] = false;
+        }
       }
     }
   }
 
-  std::vector<Feature> clearedKeypoints;
-  clearedKeypoints.reserve(features.size());
-
-  for(unsigned i=0; i<keypointStable.size(); ++i)
+  // removes the redundant keypoints from the features and their nodes alike
+  int stableKeypoints(0);
+  for(int i=0; i<size; ++i)
   {
-    const Feature& keypoint = features[i];
     if( !keypointStable[i] )
     {
-      static_cast<EntropyPayload*>(keypointNodes[i]->opt())->flag_ = REDUNDANT;
+      entropy.flags_[keypointNodes[i]->index()] = REDUNDANT;
       continue;
     }
-    clearedKeypoints.push_back(keypoint);
+    if( stableKeypoints != i )
+    {
+      features[stableKeypoints] = features[i];
+      keypointNodes[stableKeypoints] = keypointNodes[i];
+    }
+    stableKeypoints++;
   }
-  int redundantFeatures = features.size() - clearedKeypoints.size();
-  features = clearedKeypoints;
-  return redundantFeatures;
+  features.resize(stableKeypoints);
+  keypointNodes.resize(stableKeypoints);
+  return size - stableKeypoints;
 }
@@ -0,0 +1,131 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+#include <stdint.h>
+
+#include <sure/keypoints/neighborhood_cache.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+void sure::keypoints::NeighborhoodCache::clear()
+{
+  octree_ = NULL;
+  depth_ = 0;
+  unitRadius_ = 0;
+  offsets_.clear();
+  neighbors_.clear();
+}
+
+void sure::keypoints::NeighborhoodCache::build(const Octree& octree, unsigned depth, unsigned unitRadius, int threads)
+{
+  clear();
+  const NodeVector& nodes = octree.at(depth);
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
+
+  // every block of nodes collects its neighbors separately, blocks are assigned round-robin in case fewer threads are started
+  std::vector<int> blockBegin(threads+1);
+  for(int block=0; block<=threads; ++block)
+  {
+    blockBegin[block] = (int) (((int64_t) size * block) / threads);
+  }
+  if( (int) threadNeighbors_.size() < threads )
+  {
+    threadNeighbors_.resize(threads);
+  }
+  offsets_.resize(size+1);
+
+#pragma omp parallel num_threads(threads)
+  {
+    int thread(0), numberOfThreads(1);
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+    numberOfThreads = omp_get_num_threads();
+#endif
+    for(int block=thread; block<threads; block+=numberOfThreads)
+    {
+      NodeVector& blockNeighbors = threadNeighbors_[block];
+      blockNeighbors.clear();
+      NeighborCollector collector(blockNeighbors);
+      for(int i=blockBegin[block]; i<blockBegin[block+1]; ++i)
+      {
+        offsets_[i] = blockNeighbors.size();
+        octree.forEachNodeIn(nodes[i], unitRadius, depth, collector);
+      }
+    }
+  }
+
+  if( threads == 1 )
+  {
+    neighbors_.swap(threadNeighbors_[0]);
+    offsets_[size] = neighbors_.size();
+  }
+  else
+  {
+    std::vector<unsigned> blockOffset(threads+1, 0);
+    for(int block=0; block<threads; ++block)
+    {
+      blockOffset[block+1] = blockOffset[block] + threadNeighbors_[block].size();
+    }
+    neighbors_.resize(blockOffset[threads]);
+    offsets_[size] = blockOffset[threads];
+
+#pragma omp parallel for schedule(static, 1) num_threads(threads)
+    for(int block=0; block<threads; ++block)
+    {
+      for(int i=blockBegin[block]; i<blockBegin[block+1]; ++i)
+      {
+        offsets_[i] += blockOffset[block];
+      }
+      std::copy(threadNeighbors_[block].begin(), threadNeighbors_[block].end(), neighbors_.begin() + blockOffset[block]);
+    }
+  }
+
+  octree_ = &octree;
+  depth_ = depth;
+  unitRadius_ = unitRadius;
+}
+
+size_t sure::keypoints::NeighborhoodCache::memory() const
+{
+  size_t bytes = offsets_.capacity() * sizeof(unsigned) + neighbors_.capacity() * sizeof(Node*);
+  for(unsigned i=0; i<threadNeighbors_.size(); ++i)
+  {
+    bytes += threadNeighbors_[i].capacity() * sizeof(Node*);
+  }
+  return bytes;
+}
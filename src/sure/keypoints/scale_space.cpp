@@ -0,0 +1,194 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sure/keypoints/scale_space.h>
+
+void sure::keypoints::ScaleSpacePyramid::clear()
+{
+  octree_ = NULL;
+  normals_ = NULL;
+  depth_ = 0;
+  for(unsigned i=0; i<levels_.size(); ++i)
+  {
+    levels_[i].keys.clear();
+    levels_[i].children.clear();
+    levels_[i].sums.clear();
+  }
+  keys_.clear();
+  nodes_.clear();
+}
+
+void sure::keypoints::ScaleSpacePyramid::build(const Octree& octree, const NormalTable& normals, int threads)
+{
+  clear();
+  octree_ = &octree;
+  normals_ = &normals;
+  depth_ = normals.depth();
+  if( depth_ == 0 || depth_ > octree.getMaximumDepth() || depth_ > sure::octree::MAX_MORTON_DEPTH || normals.size() != octree.at(depth_).size() )
+  {
+    return;
+  }
+  origin_ = octree.at(0)[0]->region().min();
+  threads = sure::getNumberOfThreads(threads);
+
+  // sort the normal nodes along their morton keys
+  const NodeVector& nodes = octree.at(depth_);
+  const int size = nodes.size();
+  const unsigned shift = 3 * (octree.getMaximumDepth() - depth_);
+  sorted_.resize(size);
+  for(int i=0; i<size; ++i)
+  {
+    sorted_[i].key = octree.getMortonKey(nodes[i]->region().min()) >> shift;
+    sorted_[i].index = i;
+  }
+  sure::octree::sortMortonIndices(sorted_, buffer_, 3 * depth_, threads);
+  keys_.resize(size);
+  nodes_.resize(size);
+  for(int i=0; i<size; ++i)
+  {
+    keys_[i] = sorted_[i].key;
+    nodes_[i] = nodes[sorted_[i].index];
+  }
+  if( nodes_.empty() )
+  {
+    return;
+  }
+
+  // group the keys of every depth into their parents, from the normal depth up to the root
+  if( levels_.size() < depth_ )
+  {
+    levels_.resize(depth_);
+  }
+  const std::vector<MortonKey>* childKeys = &keys_;
+  for(int d=depth_-1; d>=0; --d)
+  {
+    Level& level = levels_[d];
+    for(unsigned j=0; j<childKeys->size(); ++j)
+    {
+      const MortonKey parentKey = (*childKeys)[j] >> 3;
+      if( level.keys.empty() || level.keys.back() != parentKey )
+      {
+        level.keys.push_back(parentKey);
+        level.children.push_back(j);
+      }
+    }
+    level.children.push_back(childKeys->size());
+    childKeys = &level.keys;
+  }
+
+  // sum up the histograms bottom-up, each parent adds its children in key order
+  for(int d=depth_-1; d>=0; --d)
+  {
+    Level& level = levels_[d];
+    const int parents = level.keys.size();
+    level.sums.resize(parents);
+#pragma omp parallel for schedule(dynamic, 256) num_threads(threads)
+    for(int j=0; j<parents; ++j)
+    {
+      NormalHistogram& sum = level.sums[j];
+      sum = NormalHistogram();
+      for(unsigned k=level.children[j]; k<level.children[j+1]; ++k)
+      {
+        if( d+1 == (int) depth_ )
+        {
+          sum += normals.histograms_[nodes_[k]->index()];
+        }
+        else
+        {
+          sum += levels_[d+1].sums[k];
+        }
+      }
+    }
+  }
+}
+
+sure::keypoints::ScaleSpacePyramid::Region sure::keypoints::ScaleSpacePyramid::getRegion(MortonKey key, unsigned depth) const
+{
+  unsigned x, y, z;
+  sure::octree::decodeMortonKey(key, x, y, z);
+  const int unitSize = octree_->getUnitSizeFromDepth(depth);
+  const Point min(origin_.x() + (int) x * unitSize, origin_.y() + (int) y * unitSize, origin_.z() + (int) z * unitSize);
+  return Region(min, min + unitSize);
+}
+
+unsigned sure::keypoints::ScaleSpacePyramid::integrate(const Region& r, NormalHistogram& histogram) const
+{
+  if( nodes_.empty() )
+  {
+    return 0;
+  }
+  unsigned count(0);
+  unsigned stack[TRAVERSAL_STACK_SIZE];
+  unsigned char stackDepth[TRAVERSAL_STACK_SIZE];
+  unsigned size(0);
+  stack[size] = 0;
+  stackDepth[size++] = 0;
+
+  while( size > 0 )
+  {
+    size--;
+    const unsigned index = stack[size];
+    const unsigned depth = stackDepth[size];
+    const Level& level = levels_[depth];
+
+    if( r.contains(getRegion(level.keys[index], depth)) )
+    {
+      histogram += level.sums[index];
+      count += 1;
+    }
+    else if( depth+1 < depth_ )
+    {
+      for(unsigned k=level.children[index]; k<level.children[index+1]; ++k)
+      {
+        if( r.overlaps(getRegion(levels_[depth+1].keys[k], depth+1)) )
+        {
+          stack[size] = k;
+          stackDepth[size++] = depth+1;
+        }
+      }
+    }
+    else
+    {
+      for(unsigned k=level.children[index]; k<level.children[index+1]; ++k)
+      {
+        if( r.overlaps(nodes_[k]->region()) )
+        {
+          histogram += normals_->histograms_[nodes_[k]->index()];
+          count++;
+        }
+      }
+    }
+  }
+  return count;
+}
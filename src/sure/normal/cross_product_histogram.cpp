@@ -32,6 +32,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <include/sure/normal/cross_product_histogram.h>
+#include <sure/normal/histogram_kernel.h>
 
 const sure::HistoType sure::normal::CrossProductHistogram::MAX_ENTROPY = log(CROSS_PRODUCT_HISTOGRAM_SIZE) / log(2.f);
 
@@ -42,15 +43,13 @@ void sure::normal::CrossProductHistogram::insertCrossProduct(const NormalType& r
   Scalar dotProduct = referenceNormal.dot(secondNormal);
   HistoType crossProductWeight = 1.f - fabs(dotProduct);
 
+  HistoType weights[PADDED_HISTOGRAM_SIZE];
+  calculateBinWeights(cpVector, this->influenceRadius_, weights);
   for(int i=0; i<NORMAL_HISTOGRAM_SIZE; ++i)
   {
-    HistoType distance = (cpVector.dot(sure::normal::REFERENCE_VECTORS[i]));
-    if( distance > this->influenceRadius_ )
-    {
-      HistoType weightedValue = (((distance - influenceRadius_) / (1.f - influenceRadius_))) * crossProductWeight;
-      values_[i] += weightedValue;
-      this->weight_ += weightedValue;
-    }
+    HistoType weightedValue = weights[i] * crossProductWeight;
+    values_[i] += weightedValue;
+    this->weight_ += weightedValue;
   }
 
   this->weight_ += 1.f - crossProductWeight;
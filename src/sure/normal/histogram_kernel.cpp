@@ -0,0 +1,334 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sure/normal/histogram_kernel.h>
+#include <sure/normal/base_histogram.h>
+
+#include <stdint.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SURE_X86_HISTOGRAM_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace
+{
+
+  sure::normal::ReferenceDirections buildReferenceDirections()
+  {
+    const std::vector<sure::NormalType, sure::NormalTypeAllocator> vecs = sure::normal::initVectors(sure::normal::NORMAL_HISTOGRAM_POLAR_SPLITS);
+    sure::normal::ReferenceDirections directions;
+    for(int i=0; i<sure::normal::PADDED_HISTOGRAM_SIZE; ++i)
+    {
+      if( i < sure::normal::NORMAL_HISTOGRAM_SIZE )
+      {
+        directions.x[i] = (float) vecs[i][0];
+        directions.y[i] = (float) vecs[i][1];
+        directions.z[i] = (float) vecs[i][2];
+      }
+      else
+      {
+        directions.x[i] = directions.y[i] = directions.z[i] = 0.f;
+      }
+    }
+    return directions;
+  }
+
+  // All kernels evaluate ((x*nx + y*ny) + z*nz), followed by max(d-c, 0) * 1/(1-c), in the same order, so they give the same results
+
+  void scalarBinWeights(const sure::normal::ReferenceDirections& r, const float* n, float c, float scale, float* weights)
+  {
+    for(int i=0; i<sure::normal::NORMAL_HISTOGRAM_SIZE; ++i)
+    {
+      const float distance = r.x[i] * n[0] + r.y[i] * n[1] + r.z[i] * n[2];
+      weights[i] = distance > c ? (distance - c) * scale : 0.f;
+    }
+  }
+
+  //! Coefficients of the polynomial approximating log2(1+x) for x in [0,1), lowest order first, without a constant term
+  const float LOG2_POLYNOMIAL[5] = { 1.44196558f, -0.709662974f, 0.41759631f, -0.196270362f, 0.046385698f };
+
+  //! Approximates log2 for positive, normalized floats
+  inline float approximateLog2(float value)
+  {
+    union
+    {
+        float f;
+        int32_t i;
+    } bits;
+    bits.f = value;
+    const float exponent = (float) ((bits.i >> 23) - 127);
+    bits.i = (bits.i & 0x007fffff) | 0x3f800000;
+    const float x = bits.f - 1.f;
+    return exponent + ((((LOG2_POLYNOMIAL[4] * x + LOG2_POLYNOMIAL[3]) * x + LOG2_POLYNOMIAL[2]) * x + LOG2_POLYNOMIAL[1]) * x + LOG2_POLYNOMIAL[0]) * x;
+  }
+
+  //! Returns sum(p * log2(p)) for the values from begin to end, scaled by inverseWeight
+  inline float scalarEntropySum(const float* values, int begin, int end, float inverseWeight)
+  {
+    float sum(0.f);
+    for(int i=begin; i<end; ++i)
+    {
+      const float p = values[i] * inverseWeight;
+      if( p > sure::EPSILON )
+      {
+        sum += p * approximateLog2(p);
+      }
+    }
+    return sum;
+  }
+
+#ifdef SURE_X86_HISTOGRAM_KERNELS
+
+  __attribute__((target("sse2")))
+  void sseBinWeights(const sure::normal::ReferenceDirections& r, const float* n, float c, float scale, float* weights)
+  {
+    const __m128 nx = _mm_set1_ps(n[0]);
+    const __m128 ny = _mm_set1_ps(n[1]);
+    const __m128 nz = _mm_set1_ps(n[2]);
+    const __m128 vc = _mm_set1_ps(c);
+    const __m128 vscale = _mm_set1_ps(scale);
+    const __m128 zero = _mm_setzero_ps();
+    for(int i=0; i<sure::normal::PADDED_HISTOGRAM_SIZE; i+=4)
+    {
+      __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_load_ps(r.x+i), nx), _mm_mul_ps(_mm_load_ps(r.y+i), ny));
+      distance = _mm_add_ps(distance, _mm_mul_ps(_mm_load_ps(r.z+i), nz));
+      // a NaN difference selects the second operand, so non-finite directions give zero weights
+      _mm_storeu_ps(weights+i, _mm_mul_ps(_mm_max_ps(_mm_sub_ps(distance, vc), zero), vscale));
+    }
+  }
+
+  __attribute__((target("avx2")))
+  void avx2BinWeights(const sure::normal::ReferenceDirections& r, const float* n, float c, float scale, float* weights)
+  {
+    const __m256 nx = _mm256_set1_ps(n[0]);
+    const __m256 ny = _mm256_set1_ps(n[1]);
+    const __m256 nz = _mm256_set1_ps(n[2]);
+    const __m256 vc = _mm256_set1_ps(c);
+    const __m256 vscale = _mm256_set1_ps(scale);
+    const __m256 zero = _mm256_setzero_ps();
+    for(int i=0; i<sure::normal::PADDED_HISTOGRAM_SIZE; i+=8)
+    {
+      __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(r.x+i), nx), _mm256_mul_ps(_mm256_load_ps(r.y+i), ny));
+      distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_load_ps(r.z+i), nz));
+      _mm256_storeu_ps(weights+i, _mm256_mul_ps(_mm256_max_ps(_mm256_sub_ps(distance, vc), zero), vscale));
+    }
+  }
+
+  //! Returns p * log2(p) for all four p greater than EPSILON and zero for the others
+  __attribute__((target("sse2")))
+  inline __m128 sseEntropyTerms(__m128 p)
+  {
+    const __m128i bits = _mm_castps_si128(p);
+    const __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+    const __m128 mantissa = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)), _mm_set1_epi32(0x3f800000)));
+    const __m128 x = _mm_sub_ps(mantissa, _mm_set1_ps(1.f));
+    __m128 polynomial = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(LOG2_POLYNOMIAL[4]), x), _mm_set1_ps(LOG2_POLYNOMIAL[3]));
+    polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(LOG2_POLYNOMIAL[2]));
+    polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(LOG2_POLYNOMIAL[1]));
+    polynomial = _mm_add_ps(_mm_mul_ps(polynomial, x), _mm_set1_ps(LOG2_POLYNOMIAL[0]));
+    const __m128 log2 = _mm_add_ps(exponent, _mm_mul_ps(polynomial, x));
+    return _mm_and_ps(_mm_mul_ps(p, log2), _mm_cmpgt_ps(p, _mm_set1_ps(sure::EPSILON)));
+  }
+
+  __attribute__((target("sse2")))
+  float sseEntropySum(const float* values, int size, float inverseWeight)
+  {
+    const __m128 w = _mm_set1_ps(inverseWeight);
+    __m128 sum = _mm_setzero_ps();
+    int i(0);
+    for(; i+4<=size; i+=4)
+    {
+      sum = _mm_add_ps(sum, sseEntropyTerms(_mm_mul_ps(_mm_loadu_ps(values+i), w)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + scalarEntropySum(values, i, size, inverseWeight);
+  }
+
+  //! Returns p * log2(p) for all eight p greater than EPSILON and zero for the others
+  __attribute__((target("avx2")))
+  inline __m256 avx2EntropyTerms(__m256 p)
+  {
+    const __m256i bits = _mm256_castps_si256(p);
+    const __m256 exponent = _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127)));
+    const __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)), _mm256_set1_epi32(0x3f800000)));
+    const __m256 x = _mm256_sub_ps(mantissa, _mm256_set1_ps(1.f));
+    __m256 polynomial = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(LOG2_POLYNOMIAL[4]), x), _mm256_set1_ps(LOG2_POLYNOMIAL[3]));
+    polynomial = _mm256_add_ps(_mm256_mul_ps(polynomial, x), _mm256_set1_ps(LOG2_POLYNOMIAL[2]));
+    polynomial = _mm256_add_ps(_mm256_mul_ps(polynomial, x), _mm256_set1_ps(LOG2_POLYNOMIAL[1]));
+    polynomial = _mm256_add_ps(_mm256_mul_ps(polynomial, x), _mm256_set1_ps(LOG2_POLYNOMIAL[0]));
+    const __m256 log2 = _mm256_add_ps(exponent, _mm256_mul_ps(polynomial, x));
+    return _mm256_and_ps(_mm256_mul_ps(p, log2), _mm256_cmp_ps(p, _mm256_set1_ps(sure::EPSILON), _CMP_GT_OQ));
+  }
+
+  __attribute__((target("avx2")))
+  float avx2EntropySum(const float* values, int size, float inverseWeight)
+  {
+    const __m256 w = _mm256_set1_ps(inverseWeight);
+    __m256 sum = _mm256_setzero_ps();
+    int i(0);
+    for(; i+8<=size; i+=8)
+    {
+      sum = _mm256_add_ps(sum, avx2EntropyTerms(_mm256_mul_ps(_mm256_loadu_ps(values+i), w)));
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, sum);
+    return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7])) + scalarEntropySum(values, i, size, inverseWeight);
+  }
+
+#endif
+
+  sure::normal::HistogramKernel getFastestHistogramKernel()
+  {
+#ifdef SURE_X86_HISTOGRAM_KERNELS
+    __builtin_cpu_init();
+#endif
+    if( sure::normal::isHistogramKernelSupported(sure::normal::AVX2_HISTOGRAM_KERNEL) )
+    {
+      return sure::normal::AVX2_HISTOGRAM_KERNEL;
+    }
+    if( sure::normal::isHistogramKernelSupported(sure::normal::SSE_HISTOGRAM_KERNEL) )
+    {
+      return sure::normal::SSE_HISTOGRAM_KERNEL;
+    }
+    return sure::normal::SCALAR_HISTOGRAM_KERNEL;
+  }
+
+  sure::normal::HistogramKernel& currentHistogramKernel()
+  {
+    static sure::normal::HistogramKernel kernel = getFastestHistogramKernel();
+    return kernel;
+  }
+
+}
+
+const sure::normal::ReferenceDirections& sure::normal::getReferenceDirections()
+{
+  static const ReferenceDirections directions = buildReferenceDirections();
+  return directions;
+}
+
+bool sure::normal::isHistogramKernelSupported(HistogramKernel kernel)
+{
+  switch( kernel )
+  {
+    case SCALAR_HISTOGRAM_KERNEL:
+      return true;
+#ifdef SURE_X86_HISTOGRAM_KERNELS
+    case SSE_HISTOGRAM_KERNEL:
+      return __builtin_cpu_supports("sse2");
+    case AVX2_HISTOGRAM_KERNEL:
+      return __builtin_cpu_supports("avx2");
+#endif
+    default:
+      return false;
+  }
+}
+
+sure::normal::HistogramKernel sure::normal::getHistogramKernel()
+{
+  return currentHistogramKernel();
+}
+
+bool sure::normal::setHistogramKernel(HistogramKernel kernel)
+{
+  if( !isHistogramKernelSupported(kernel) )
+  {
+    return false;
+  }
+  currentHistogramKernel() = kernel;
+  return true;
+}
+
+void sure::normal::calculateBinWeights(const NormalType& direction, Scalar influenceRadius, HistoType* weights)
+{
+  calculateBinWeights(currentHistogramKernel(), direction, influenceRadius, weights);
+}
+
+void sure::normal::calculateBinWeights(HistogramKernel kernel, const NormalType& direction, Scalar influenceRadius, HistoType* weights)
+{
+  const ReferenceDirections& directions = getReferenceDirections();
+  const float n[3] = { (float) direction[0], (float) direction[1], (float) direction[2] };
+  const float c = (float) influenceRadius;
+  const float scale = 1.f / (1.f - c);
+
+  switch( kernel )
+  {
+#ifdef SURE_X86_HISTOGRAM_KERNELS
+    case AVX2_HISTOGRAM_KERNEL:
+      avx2BinWeights(directions, n, c, scale, weights);
+      break;
+    case SSE_HISTOGRAM_KERNEL:
+      sseBinWeights(directions, n, c, scale, weights);
+      break;
+#endif
+    default:
+      scalarBinWeights(directions, n, c, scale, weights);
+      break;
+  }
+
+  // padding bins may have been weighted against the zero directions, if the influence radius is greater than 90 degrees
+  for(int i=NORMAL_HISTOGRAM_SIZE; i<PADDED_HISTOGRAM_SIZE; ++i)
+  {
+    weights[i] = 0.f;
+  }
+}
+
+sure::HistoType sure::normal::calculateApproximateEntropy(const HistoType* values, int size, HistoType weight)
+{
+  return calculateApproximateEntropy(currentHistogramKernel(), values, size, weight);
+}
+
+sure::HistoType sure::normal::calculateApproximateEntropy(HistogramKernel kernel, const HistoType* values, int size, HistoType weight)
+{
+  const float inverseWeight = 1.f / weight;
+  float sum(0.f);
+
+  switch( kernel )
+  {
+#ifdef SURE_X86_HISTOGRAM_KERNELS
+    case AVX2_HISTOGRAM_KERNEL:
+      sum = avx2EntropySum(values, size, inverseWeight);
+      break;
+    case SSE_HISTOGRAM_KERNEL:
+      sum = sseEntropySum(values, size, inverseWeight);
+      break;
+#endif
+    default:
+      sum = scalarEntropySum(values, 0, size, inverseWeight);
+      break;
+  }
+  return -sum;
+}
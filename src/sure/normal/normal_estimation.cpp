@@ -33,16 +33,10 @@
 
 #include <sure/normal/normal_estimation.h>
 
-void sure::normal::allocateNormalPayload(Octree& octree, Scalar samplingrate, sure::memory::FixedSizeAllocatorWithDirectAccess<NormalPayload>& allocator)
+void sure::normal::allocateNormalPayload(Octree& octree, Scalar samplingrate, NormalTable& normals)
 {
   unsigned depth = octree.getDepth(samplingrate);
-  allocator.resizeIfSmaller(octree[depth].size());
-  for(unsigned int i=0; i<octree[depth].size(); ++i)
-  {
-    Node* node = octree[depth][i];
-    NormalPayload* payload = allocator.allocate(i);
-    node->setOptionalPayload(static_cast<sure::payload::Payload*>(payload));
-  }
+  normals.reset(depth, octree[depth].size());
 }
 
 void sure::normal::orientateNormal(const Vector3& pos, Normal& normal, const Vector3& orientation)
@@ -55,7 +49,7 @@ void sure::normal::orientateNormal(const Vector3& pos, Normal& normal, const Vec
 
 bool sure::normal::estimateNormal(const Octree& octree, const Vector3& p, Scalar radius, Normal& normal)
 {
-  PointsRGB regionIntegrate;
+  FixedPayload regionIntegrate;
   octree.integratePayload(p, radius, regionIntegrate);
 
   normal = regionIntegrate.calculateNormal();
@@ -63,34 +57,43 @@ bool sure::normal::estimateNormal(const Octree& octree, const Vector3& p, Scalar
 }
 
 
-unsigned sure::normal::estimateNormals(Octree& octree, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence)
+unsigned sure::normal::estimateNormals(Octree& octree, NormalTable& normals, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence, int threads)
 {
   unsigned count(0);
   unsigned depth = octree.getDepth(samplingrate);
+  const NodeVector& nodes = octree[depth];
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
 
-  for(unsigned int i=0; i<octree[depth].size(); ++i)
+  // builds the summed-volume table used by estimateNormal, if enabled, before the nodes are processed concurrently
+  octree.getSummedVolumeTable(octree.getMaximumDepth());
+
+  // every node only writes its own normal, so the results do not depend on the number of threads
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads) reduction(+:count)
+  for(int i=0; i<size; ++i)
   {
-    Node* currNode = octree[depth][i];
-    NormalPayload* payload = static_cast<NormalPayload*>(currNode->opt());
+    Node* currNode = nodes[i];
+    Normal& normal = normals.normals_[i];
 
-    if( payload->normal_.getStatus() != Normal::NORMAL_NOT_CALCULATED )
+    if( normal.getStatus() != Normal::NORMAL_NOT_CALCULATED )
     {
       continue;
     }
 
-    if( estimateNormal(octree, currNode->fixed().getMeanPosition(), radius, payload->normal_) )
+    if( estimateNormal(octree, currNode->fixed().getMeanPosition(), radius, normal) )
     {
-      orientateNormal(currNode->fixed().getMeanPosition(), payload->normal_, orientationPoint);
+      orientateNormal(currNode->fixed().getMeanPosition(), normal, orientationPoint);
 
-      payload->histogram_.setInfluenceRadius(histogramInfluence);
-      payload->histogram_.insertNormal(payload->normal_);
+      NormalHistogram& histogram = normals.histograms_[i];
+      histogram.setInfluenceRadius(histogramInfluence);
+      histogram.insertNormal(normal);
       count++;
     }
   }
   return count;
 }
 
-unsigned sure::normal::discardNormalsfromNodesWithFlag(Octree& octree, Scalar samplingrate, PointFlag flag)
+unsigned sure::normal::discardNormalsfromNodesWithFlag(Octree& octree, NormalTable& normals, Scalar samplingrate, PointFlag flag)
 {
   unsigned count(0);
   unsigned depth = octree.getDepth(samplingrate);
@@ -98,11 +101,10 @@ unsigned sure::normal::discardNormalsfromNodesWithFlag(Octree& octree, Scalar sa
   for(unsigned int i=0; i<octree[depth].size(); ++i)
   {
     Node* currNode = octree[depth][i];
-    NormalPayload* payload = static_cast<NormalPayload*>(currNode->opt());
 
     if( (currNode->fixed().getPointFlag() | flag) == flag )
     {
-      payload->normal_.setUnstable();
+      normals.normals_[i].setUnstable();
       count++;
     }
   }
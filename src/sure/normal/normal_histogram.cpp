@@ -32,6 +32,7 @@
 // POSSIBILITY OF SUCH DAMAGE.
 
 #include <sure/normal/normal_histogram.h>
+#include <sure/normal/histogram_kernel.h>
 
 const sure::HistoType sure::normal::NormalHistogram::MAX_ENTROPY = log(NORMAL_HISTOGRAM_SIZE) / log(2.f);
 
@@ -39,26 +40,18 @@ void sure::normal::NormalHistogram::insertNormal(const sure::NormalType& normal)
 {
   this->clear();
   numberOfEntries_ = 1;
-  float distance = 0.f, totalSum = 0.f, weightedValue;
+  HistoType weights[PADDED_HISTOGRAM_SIZE];
+  calculateBinWeights(normal, influenceRadius_, weights);
+  float totalSum = 0.f;
   for(int i=0; i<NORMAL_HISTOGRAM_SIZE; ++i)
   {
-    distance = (normal.dot(sure::normal::REFERENCE_VECTORS[i]));
-    if( distance > influenceRadius_ )
-    {
-      weightedValue = (((distance - influenceRadius_) / (1.f - influenceRadius_)));
-      totalSum += weightedValue;
-      values_[i] = weightedValue;
-    }
-    else
-    {
-      values_[i] = 0.f;
-    }
+    totalSum += weights[i];
   }
   if( totalSum > 0.f )
   {
     for(int i=0; i<NORMAL_HISTOGRAM_SIZE; ++i)
     {
-      values_[i] = (values_[i] / totalSum);
+      values_[i] = (weights[i] / totalSum);
       weight_ += values_[i];
     }
   }
@@ -0,0 +1,300 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <sure/normal/organized_normal_estimation.h>
+
+const sure::Scalar sure::normal::IntegralMomentImage::MAX_PROJECTION_ERROR = 0.5;
+
+bool sure::normal::IntegralMomentImage::fitAxis(const std::vector<Scalar>& coordinates, const std::vector<Scalar>& pixels, Scalar& focal, Scalar& center)
+{
+  const std::size_t samples = coordinates.size();
+  if( samples < 2 )
+  {
+    return false;
+  }
+  Scalar meanCoordinate(0.0), meanPixel(0.0);
+  for(std::size_t i=0; i<samples; ++i)
+  {
+    meanCoordinate += coordinates[i];
+    meanPixel += pixels[i];
+  }
+  meanCoordinate /= (Scalar) samples;
+  meanPixel /= (Scalar) samples;
+
+  Scalar covariance(0.0), variance(0.0);
+  for(std::size_t i=0; i<samples; ++i)
+  {
+    covariance += (coordinates[i] - meanCoordinate) * (pixels[i] - meanPixel);
+    variance += (coordinates[i] - meanCoordinate) * (coordinates[i] - meanCoordinate);
+  }
+  if( !(variance > 0.0) )
+  {
+    return false;
+  }
+  focal = covariance / variance;
+  center = meanPixel - focal * meanCoordinate;
+
+  Scalar error(0.0);
+  for(std::size_t i=0; i<samples; ++i)
+  {
+    error += fabs(focal * coordinates[i] + center - pixels[i]);
+  }
+  return error / (Scalar) samples <= MAX_PROJECTION_ERROR;
+}
+
+inline float sure::normal::IntegralMomentImage::addPixel(const pcl::PointXYZRGB& point, bool border, double* sums) const
+{
+  if( !std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z) )
+  {
+    return INFINITY;
+  }
+  const double px = point.x - origin_[0], py = point.y - origin_[1], pz = point.z - origin_[2];
+  sums[0] += 1.0;
+  sums[1] += border ? 1.0 : 0.0;
+  sums[2] += px;
+  sums[3] += py;
+  sums[4] += pz;
+  sums[5] += px*px;
+  sums[6] += px*py;
+  sums[7] += px*pz;
+  sums[8] += py*py;
+  sums[9] += py*pz;
+  sums[10] += pz*pz;
+  return sqrt(px*px + py*py + pz*pz);
+}
+
+bool sure::normal::IntegralMomentImage::build(const OrganizedCloud& cloud, const RangeImage& rangeImage, int threads)
+{
+  clear();
+  const int w = cloud.width, h = cloud.height;
+  if( w <= 1 || h <= 1 || cloud.size() != (std::size_t) w*h || rangeImage.size != cloud.size() )
+  {
+    return false;
+  }
+  threads = sure::getNumberOfThreads(threads);
+  origin_ = Vector3(cloud.sensor_origin_[0], cloud.sensor_origin_[1], cloud.sensor_origin_[2]);
+  toCamera_ = cloud.sensor_orientation_.inverse().toRotationMatrix().cast<Scalar>();
+
+  // camera model from a regular subset of the pixels
+  std::vector<Scalar> coordinates[2], pixels[2];
+  for(int y=0; y<h; y+=FIT_STEP)
+  {
+    for(int x=0; x<w; x+=FIT_STEP)
+    {
+      const pcl::PointXYZRGB& point = cloud.points[y*w+x];
+      if( !std::isfinite(point.x) || !std::isfinite(point.y) || !std::isfinite(point.z) )
+      {
+        continue;
+      }
+      const Vector3 c(toCamera_ * (Vector3(point.x, point.y, point.z) - origin_));
+      if( c[2] > 0.0 )
+      {
+        coordinates[0].push_back(c[0] / c[2]);
+        coordinates[1].push_back(c[1] / c[2]);
+        pixels[0].push_back(x);
+        pixels[1].push_back(y);
+      }
+    }
+  }
+  if( !fitAxis(coordinates[0], pixels[0], focal_[0], center_[0]) || !fitAxis(coordinates[1], pixels[1], focal_[1], center_[1]) )
+  {
+    return false;
+  }
+
+  width_ = w;
+  height_ = h;
+  const int strips = (w + STRIP_SIZE - 1) / STRIP_SIZE;
+  table_.resize((std::size_t) (w+1) * (h+1) * CHANNELS);
+  stripSums_.resize((std::size_t) h * strips * CHANNELS);
+  ranges_.resize((std::size_t) w*h);
+  std::fill(table_.begin(), table_.begin() + (w+1) * CHANNELS, 0.0);
+
+  // sums of every strip of columns within a row, turned into the sums of all strips left of it
+#pragma omp parallel for schedule(dynamic, 16) num_threads(threads)
+  for(int y=0; y<h; ++y)
+  {
+    double sums[CHANNELS] = { 0.0 };
+    for(int strip=0; strip<strips; ++strip)
+    {
+      std::copy(sums, sums + CHANNELS, &stripSums_[((std::size_t) y * strips + strip) * CHANNELS]);
+      for(int x=strip*STRIP_SIZE, index=y*w+x; x<std::min((strip+1)*STRIP_SIZE, w); ++x, ++index)
+      {
+        ranges_[index] = addPixel(cloud.points[index], rangeImage.hasBorder(index) != RangeImage::NONE, sums);
+      }
+    }
+  }
+
+  // every strip is integrated from top to bottom, so the previous row is still cached
+#pragma omp parallel for schedule(dynamic, 1) num_threads(threads)
+  for(int strip=0; strip<strips; ++strip)
+  {
+    const int begin = strip * STRIP_SIZE, end = std::min(begin + STRIP_SIZE, w);
+    for(int y=0; y<h; ++y)
+    {
+      double sums[CHANNELS];
+      std::copy(&stripSums_[((std::size_t) y * strips + strip) * CHANNELS], &stripSums_[((std::size_t) y * strips + strip + 1) * CHANNELS], sums);
+      double* row = &table_[(std::size_t) (y+1) * (w+1) * CHANNELS];
+      const double* previous = row - (w+1) * CHANNELS;
+      if( strip == 0 )
+      {
+        std::fill(row, row + CHANNELS, 0.0);
+      }
+      for(int x=begin, index=y*w+begin; x<end; ++x, ++index)
+      {
+        if( !isinf(ranges_[index]) )
+        {
+          addPixel(cloud.points[index], rangeImage.hasBorder(index) != RangeImage::NONE, sums);
+        }
+        double* cell = row + (x+1) * CHANNELS;
+        const double* above = previous + (x+1) * CHANNELS;
+        for(int i=0; i<CHANNELS; ++i)
+        {
+          cell[i] = above[i] + sums[i];
+        }
+      }
+    }
+  }
+  valid_ = true;
+  return valid_;
+}
+
+void sure::normal::IntegralMomentImage::sum(int x0, int y0, int x1, int y1, double* values) const
+{
+  const double* a = at(x0, y0);
+  const double* b = at(x1+1, y0);
+  const double* c = at(x0, y1+1);
+  const double* d = at(x1+1, y1+1);
+  for(int i=0; i<CHANNELS; ++i)
+  {
+    values[i] = d[i] - b[i] - c[i] + a[i];
+  }
+}
+
+bool sure::normal::IntegralMomentImage::integrate(const Vector3& p, Scalar radius, FixedPayload& payload) const
+{
+  if( !valid_ )
+  {
+    return false;
+  }
+  const Vector3 relative(p - origin_);
+  const Vector3 c(toCamera_ * relative);
+  if( !(c[2] > 0.0) )
+  {
+    return false;
+  }
+  const int x = (int) floor(focal_[0] * c[0] / c[2] + center_[0] + 0.5);
+  const int y = (int) floor(focal_[1] * c[1] / c[2] + center_[1] + 0.5);
+  if( x < 0 || y < 0 || x >= width_ || y >= height_ )
+  {
+    return false;
+  }
+  // the pixel has to show the surface of the position
+  if( !(fabs(ranges_[y*width_+x] - relative.norm()) <= radius) )
+  {
+    return false;
+  }
+
+  const int radiusX = std::max(1, (int) ceil(radius * fabs(focal_[0]) / c[2]));
+  const int radiusY = std::max(1, (int) ceil(radius * fabs(focal_[1]) / c[2]));
+  double values[CHANNELS];
+  sum(std::max(x - radiusX, 0), std::max(y - radiusY, 0), std::min(x + radiusX, width_-1), std::min(y + radiusY, height_-1), values);
+  if( values[1] > 0.0 || values[0] < 1.0 )
+  {
+    return false;
+  }
+
+  // points within the box deviate at most by the radius along every axis, the converse does not hold
+  const double points = values[0];
+  const int diagonal[3] = { 5, 8, 10 };
+  for(int i=0; i<3; ++i)
+  {
+    const double mean = values[2+i] / points;
+    if( values[diagonal[i]] / points - mean * mean > radius * radius )
+    {
+      return false;
+    }
+  }
+  payload.setMoments((unsigned) points, values + 2, values + 5);
+  return true;
+}
+
+unsigned sure::normal::estimateNormals(Octree& octree, NormalTable& normals, const IntegralMomentImage& image, Scalar samplingrate, Scalar radius, const Vector3& orientationPoint, Scalar histogramInfluence, unsigned& imageNormals, int threads)
+{
+  unsigned count(0), integrated(0);
+  unsigned depth = octree.getDepth(samplingrate);
+  const NodeVector& nodes = octree[depth];
+  const int size = nodes.size();
+  threads = sure::getNumberOfThreads(threads);
+
+  // builds the summed-volume table used by estimateNormal, if enabled, before the nodes are processed concurrently
+  octree.getSummedVolumeTable(octree.getMaximumDepth());
+
+#pragma omp parallel for schedule(dynamic, 64) num_threads(threads) reduction(+:count,integrated)
+  for(int i=0; i<size; ++i)
+  {
+    Node* currNode = nodes[i];
+    Normal& normal = normals.normals_[i];
+
+    if( normal.getStatus() != Normal::NORMAL_NOT_CALCULATED )
+    {
+      continue;
+    }
+
+    const Vector3 position(currNode->fixed().getMeanPosition());
+    FixedPayload window;
+    bool stable;
+    if( image.integrate(position, radius, window) )
+    {
+      normal = window.calculateNormal();
+      stable = normal.isStable();
+      integrated++;
+    }
+    else
+    {
+      stable = estimateNormal(octree, position, radius, normal);
+    }
+
+    if( stable )
+    {
+      orientateNormal(position, normal, orientationPoint);
+
+      NormalHistogram& histogram = normals.histograms_[i];
+      histogram.setInfluenceRadius(histogramInfluence);
+      histogram.insertNormal(normal);
+      count++;
+    }
+  }
+  imageNormals = integrated;
+  return count;
+}
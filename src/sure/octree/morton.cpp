@@ -0,0 +1,122 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <algorithm>
+
+#include <sure/octree/morton.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+void sure::octree::sortMortonIndices(std::vector<MortonIndex>& data, std::vector<MortonIndex>& buffer, unsigned keyBits, int threads)
+{
+  static const unsigned RADIX_BITS = 8;
+  static const unsigned BUCKETS = 1 << RADIX_BITS;
+
+  const int size = data.size();
+  buffer.resize(size);
+
+  threads = sure::getNumberOfThreads(threads);
+  std::vector<unsigned> offsets(threads * BUCKETS);
+
+  for(unsigned shift=0; shift<keyBits; shift+=RADIX_BITS)
+  {
+    std::fill(offsets.begin(), offsets.end(), 0);
+#pragma omp parallel num_threads(threads)
+    {
+      int thread(0), numberOfThreads(1);
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+      numberOfThreads = omp_get_num_threads();
+#endif
+      // Every thread works on a contiguous block, so the scatter keeps the order within each bucket
+      const int begin = (int) (((int64_t) size * thread) / numberOfThreads);
+      const int end = (int) (((int64_t) size * (thread+1)) / numberOfThreads);
+      unsigned* offset = &offsets[thread * BUCKETS];
+
+      for(int i=begin; i<end; ++i)
+      {
+        offset[(data[i].key >> shift) & (BUCKETS-1)]++;
+      }
+
+#pragma omp barrier
+#pragma omp single
+      {
+        unsigned sum(0);
+        for(unsigned b=0; b<BUCKETS; ++b)
+        {
+          for(int t=0; t<numberOfThreads; ++t)
+          {
+            unsigned count = offsets[t * BUCKETS + b];
+            offsets[t * BUCKETS + b] = sum;
+            sum += count;
+          }
+        }
+      }
+
+      for(int i=begin; i<end; ++i)
+      {
+        buffer[offset[(data[i].key >> shift) & (BUCKETS-1)]++] = data[i];
+      }
+    }
+    data.swap(buffer);
+  }
+}
+
+void sure::octree::groupMortonIndices(std::vector<MortonIndex>& points, MortonKey invalidKey, std::vector<MortonKey>& leafKeys, std::vector<unsigned>& leafBegin, int threads)
+{
+  unsigned keyBits(1);
+  while( keyBits < 64 && (invalidKey >> keyBits) )
+  {
+    keyBits++;
+  }
+  {
+    std::vector<MortonIndex> buffer;
+    sortMortonIndices(points, buffer, keyBits, threads);
+  }
+
+  leafKeys.clear();
+  leafBegin.clear();
+  unsigned end(0);
+  for(; end<points.size() && points[end].key != invalidKey; ++end)
+  {
+    if( end == 0 || points[end].key != points[end-1].key )
+    {
+      leafBegin.push_back(end);
+      leafKeys.push_back(points[end].key);
+    }
+  }
+  leafBegin.push_back(end);
+}
@@ -51,15 +51,27 @@ bool sure::SUREFeatureExtractor::calculateSURE()
   }
 
   bool ret(true);
+  statistics.clear();
+  statistics.points = input_->size();
+  StageTimer total, timer;
 
   ret &= buildOctree();
+  statistics.stages[Statistics::OCTREE_STAGE] = timer.lap();
 
   ret &= calculateNormals();
+  statistics.stages[Statistics::NORMAL_STAGE] = timer.lap();
 
   ret &= extractKeypoints();
+  statistics.stages[Statistics::KEYPOINT_STAGE] = timer.lap();
 
   ret &= extractFeatures();
+  statistics.stages[Statistics::FEATURE_STAGE] = timer.lap();
+  statistics.total = total.getTime();
 
+  if( verbose )
+  {
+    std::cout << "\n" << statistics;
+  }
 
   return ret;
 }
@@ -70,7 +82,6 @@ pcl::PointCloud<pcl::InterestPoint>::Ptr sure::SUREFeatureExtractor::getInterest
   for(unsigned i=0; i<features.size(); ++i)
   {
     const Feature& currFeature = features[i];
-    sure::payload::EntropyPayload* entropyPayload = dynamic_cast<sure::payload::EntropyPayload*>(keypointNodes_[i]->opt());
     pcl::InterestPoint p;
     p.x = currFeature.position()[0];
     p.y = currFeature.position()[1];
@@ -85,7 +96,7 @@ pcl::PointCloud<pcl::InterestPoint>::Ptr sure::SUREFeatureExtractor::getInterest
 bool sure::SUREFeatureExtractor::buildOctree()
 {
   bool useRangeImage = config.AdditionalPointsOnDepthBorders || config.IgnoreBackgroundDetections || config.IgnoreNormalsOnBackgroundDepthBorders;
-  if( useRangeImage && (input_->height == 1 || input_->width == 1) )
+  if( (useRangeImage || config.OrganizedNormalEstimation) && (input_->height == 1 || input_->width == 1) )
   {
     useRangeImage = false;
     std::cout << "Pointcloud is not organized, cannot use RangeImage.\n";
@@ -93,14 +104,20 @@ bool sure::SUREFeatureExtractor::buildOctree()
   addedPoints.clear();
   Vector3 octreeCenter(config.OctreeCenter[0], config.OctreeCenter[1], config.OctreeCenter[2]);
 
+  octree.setReuseMemory(config.ReuseMemoryBetweenFrames);
   octree.initialize(config.OctreeSmallestVoxelSize, config.OctreeRootVoxelSize, config.OctreeMaximumNumberOfNodes, octreeCenter);
+  octree.setConstructionMode(config.OctreeConstruction);
+  octree.setNumberOfThreads(config.NumberOfThreads);
+  octree.setSummedVolumeTableLimit(std::max(config.SummedVolumeTableMaximumCells, 0));
 
   pcl::StopWatch watch;
 
-  if( useRangeImage )
+  // the organized normal estimation needs the depth borders, but not the border flags in the octree
+  if( useRangeImage || (config.OrganizedNormalEstimation && input_->height > 1 && input_->width > 1) )
   {
     rangeImage.clear();
     rangeImage.setInputCloud(input_);
+    rangeImage.setNumberOfThreads(config.NumberOfThreads);
     rangeImage.calculateRangeImage();
     if( verbose )
     {
@@ -126,7 +143,7 @@ bool sure::SUREFeatureExtractor::buildOctree()
     {
       Scalar dist = config.Samplingrate * 2.0;
       Scalar step = config.OctreeSmallestVoxelSize;
-      rangeImage.addPointsOnBorders(step, dist, addedPoints);
+      rangeImage.addPointsOnBorders(step, dist, addedPoints, std::max(config.MaximumPointsOnDepthBorders, 0));
       octree.addArtificialPointCloud(addedPoints);
     }
   }
@@ -136,6 +153,17 @@ bool sure::SUREFeatureExtractor::buildOctree()
     return false;
   }
 
+  statistics.artificialPoints = addedPoints.size();
+  for(unsigned i=0; i<=octree.getMaximumDepth(); ++i)
+  {
+    statistics.nodesPerDepth.push_back(octree.getNumberOfNodes(i));
+  }
+  const Allocator& allocator = octree.getAllocator();
+  statistics.allocatorSize = allocator.size();
+  statistics.allocatorCapacity = allocator.capacity();
+  statistics.allocatorHighWaterMark = allocator.highWaterMark();
+  statistics.allocatorMemory = allocator.memory();
+
   if( verbose )
   {
     std::cout << octree << "\n";
@@ -155,17 +183,32 @@ bool sure::SUREFeatureExtractor::calculateNormals()
   Vector3 orientationPoint(input_->sensor_origin_[0], input_->sensor_origin_[1], input_->sensor_origin_[2]);
 
   pcl::StopWatch watch;
-  sure::normal::allocateNormalPayload(octree, normalSamplingrate, normalAllocator_);
+  sure::normal::allocateNormalPayload(octree, normalSamplingrate, normals_);
 
   if( config.IgnoreNormalsOnBackgroundDepthBorders )
   {
-    sure::normal::discardNormalsfromNodesWithFlag(octree, normalSamplingrate, BACKGROUND_BORDER);
+    sure::normal::discardNormalsfromNodesWithFlag(octree, normals_, normalSamplingrate, BACKGROUND_BORDER);
   }
-  unsigned normals = sure::normal::estimateNormals(octree, normalSamplingrate, normalRadius, orientationPoint, config.NormalInfluenceRadius);
+  unsigned normals, imageNormals(0);
+  if( config.OrganizedNormalEstimation && momentImage_.build(*input_, rangeImage, config.NumberOfThreads) )
+  {
+    normals = sure::normal::estimateNormals(octree, normals_, momentImage_, normalSamplingrate, normalRadius, orientationPoint, config.NormalInfluenceRadius, imageNormals, config.NumberOfThreads);
+  }
+  else
+  {
+    normals = sure::normal::estimateNormals(octree, normals_, normalSamplingrate, normalRadius, orientationPoint, config.NormalInfluenceRadius, config.NumberOfThreads);
+  }
+  statistics.normals = normals;
+  statistics.imageNormals = imageNormals;
 
   if( verbose )
   {
-    std::cout << "Calculated " << normals << " normals in " << watch.getTime() << "ms\n";
+    std::cout << "Calculated " << normals << " normals in " << watch.getTime() << "ms";
+    if( config.OrganizedNormalEstimation )
+    {
+      std::cout << " - " << imageNormals << " integrated with integral images";
+    }
+    std::cout << "\n";
   }
   return true;
 }
@@ -179,20 +222,29 @@ bool sure::SUREFeatureExtractor::extractKeypoints()
 
   features.clear();
   keypointNodes_.clear();
+  // the neighborhoods of a former octree must not be used
+  neighborhoods_.clear();
 
   pcl::StopWatch watch;
 
-  sure::keypoints::allocateEntropyPayload(octree, samplingrate, entropyAllocator_);
+  sure::keypoints::allocateEntropyPayload(octree, samplingrate, entropy_);
 
-  keypoints::flagArtificialPoints(octree, samplingrate);
+  keypoints::flagArtificialPoints(octree, entropy_, samplingrate);
 
   if( config.DistanceThreshold > 0.0 )
   {
-    keypoints::flagDistantPoints(octree, samplingrate, config.DistanceThreshold, sensorPosition);
+    keypoints::flagDistantPoints(octree, entropy_, samplingrate, config.DistanceThreshold, sensorPosition);
   }
   if( config.IgnoreBackgroundDetections )
   {
-    keypoints::flagBackgroundPoints(octree, samplingrate);
+    keypoints::flagBackgroundPoints(octree, entropy_, samplingrate);
+  }
+
+  unsigned samplingDepth = octree.getDepth(samplingrate);
+  bool useScaleSpace = config.ScaleSpaceEntropy && entropyMode == NORMALS;
+  if( useScaleSpace )
+  {
+    scaleSpace_.build(octree, normals_, config.NumberOfThreads);
   }
 
   for(unsigned int i=0; i<config.getScales().size(); ++i)
@@ -202,17 +254,36 @@ bool sure::SUREFeatureExtractor::extractKeypoints()
     Scalar cornernessRadius = radius;
     Scalar suppressionRadius = config.FeatureSuppressionRatio * radius;
     Scalar localizationRadius = radius;
+    ScaleStatistics scaleStatistics(currentScale);
+    StageTimer scaleTimer;
 
-    keypoints::resetFeatureFlags(octree, samplingrate);
+    keypoints::resetFeatureFlags(octree, entropy_, samplingrate);
 
-    keypoints::calculateEntropy(octree, samplingrate, normalSamplingrate, radius, config.MinimumEntropyThreshold, entropyMode, config.NormalInfluenceRadius);
+    if( useScaleSpace )
+    {
+      keypoints::calculateEntropy(octree, scaleSpace_, entropy_, samplingrate, radius, config.MinimumEntropyThreshold, config.NumberOfThreads, config.ApproximateEntropy);
+    }
+    else
+    {
+      keypoints::calculateEntropy(octree, normals_, entropy_, samplingrate, normalSamplingrate, radius, config.MinimumEntropyThreshold, entropyMode, config.NormalInfluenceRadius, config.NumberOfThreads, config.ApproximateEntropy);
+    }
 
     if( config.MinimumCornernessThreshold > 0.0 )
     {
-      keypoints::calculateCornerness(octree, samplingrate, cornernessRadius, config.MinimumCornernessThreshold);
+      if( config.CacheNeighborhoods )
+      {
+        neighborhoods_.build(octree, samplingDepth, octree.getUnitSize(cornernessRadius), config.NumberOfThreads);
+      }
+      keypoints::calculateCornerness(octree, entropy_, samplingrate, cornernessRadius, config.MinimumCornernessThreshold, config.NumberOfThreads, &neighborhoods_);
     }
 
-    unsigned keypoints = keypoints::extractKeypoints(octree, samplingrate, suppressionRadius, radius, features, keypointNodes_);
+    // the neighborhoods are shared with the cornerness calculation for equal radii
+    if( config.CacheNeighborhoods && !neighborhoods_.contains(octree, samplingDepth, octree.getUnitSize(suppressionRadius)) )
+    {
+      neighborhoods_.build(octree, samplingDepth, octree.getUnitSize(suppressionRadius), config.NumberOfThreads);
+    }
+    unsigned keypoints = keypoints::extractKeypoints(octree, entropy_, samplingrate, suppressionRadius, radius, features, keypointNodes_, &neighborhoods_);
+    scaleStatistics.keypoints = keypoints;
     if( verbose )
     {
       std::cout << "Calculated " << keypoints << " keypoints with a scale of " << (currentScale * 100.f) << "cm\n";
@@ -220,15 +291,25 @@ bool sure::SUREFeatureExtractor::extractKeypoints()
 
     if( config.ImproveLocalization )
     {
-      keypoints::improveLocalization(octree, samplingrate, localizationRadius, features);
-      int redundantKeypoints = keypoints::removeRedundantKeypoints(localizationRadius, features, keypointNodes_);
+      keypoints::improveLocalization(octree, entropy_, samplingrate, localizationRadius, features);
+      int redundantKeypoints = keypoints::removeRedundantKeypoints(entropy_, localizationRadius, features, keypointNodes_);
+      scaleStatistics.redundantKeypoints = redundantKeypoints;
       if( verbose )
       {
         std::cout << "Removed " << redundantKeypoints << " Features after localization\n";
       }
     }
 
+    scaleStatistics.time = scaleTimer.getTime();
+    // the flags are reset for the next scale
+    for(unsigned j=0; j<entropy_.flags_.size(); ++j)
+    {
+      scaleStatistics.flagCounts[entropy_.flags_[j]]++;
+      statistics.flagCounts[entropy_.flags_[j]]++;
+    }
+    statistics.scales.push_back(scaleStatistics);
   }
+  statistics.keypoints = features.size();
 
   if( verbose )
   {
@@ -245,7 +326,8 @@ bool sure::SUREFeatureExtractor::extractFeatures()
 
   pcl::StopWatch watch;
 
-  unsigned descriptors = sure::feature::createDescriptors(octree, features, samplingrate, normalOrientationPoint, numberOfDistanceClasses);
+  unsigned descriptors = sure::feature::createDescriptors(octree, normals_, features, samplingrate, normalOrientationPoint, numberOfDistanceClasses, config.NumberOfThreads);
+  statistics.descriptors = descriptors;
 
   if( verbose )
   {
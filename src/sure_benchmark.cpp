@@ -0,0 +1,607 @@
+// Software License Agreement (BSD License)
+//
+// Copyright (c) 2012-2013, Fraunhofer FKIE/US
+// All rights reserved.
+// Author: Torsten Fiolka
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions
+// are met:
+//
+//  * Redistributions of source code must retain the above copyright
+//    notice, this list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above
+//    copyright notice, this list of conditions and the following
+//    disclaimer in the documentation and/or other materials provided
+//    with the distribution.
+//  * Neither the name of Fraunhofer FKIE nor the names of its
+//    contributors may be used to endorse or promote products derived
+//    from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+// "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+// COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+// INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+// BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+// CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+// LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+// ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include <sys/resource.h>
+
+#include <sure/sure.h>
+
+#include <pcl/point_cloud.h>
+#include <pcl/io/pcd_io.h>
+#include <pcl/common/time.h>
+
+typedef pcl::PointCloud<pcl::PointXYZRGB> PointCloud;
+
+//! The stages of sure::Statistics followed by the total time
+const int NUMBER_OF_STAGES = sure::Statistics::NUMBER_OF_STAGES + 1;
+const int TOTAL = sure::Statistics::NUMBER_OF_STAGES;
+
+/**
+ * An oriented box with a uniform base color. A box with a zero extent is a bounded plane.
+ */
+struct Box
+{
+  Box(const Eigen::Vector3f& c, const Eigen::Vector3f& h, const Eigen::Matrix3f& r, int red, int green, int blue) : center(c), halfSize(h), rotation(r)
+  {
+    color[0] = red;
+    color[1] = green;
+    color[2] = blue;
+  }
+
+  Eigen::Vector3f center, halfSize;
+  Eigen::Matrix3f rotation;
+  int color[3];
+
+  /**
+   * Intersects a ray from the origin with the box. Returns the distance along the ray or a negative value.
+   */
+  float intersect(const Eigen::Vector3f& ray) const
+  {
+    const Eigen::Vector3f origin = rotation.transpose() * (-center);
+    const Eigen::Vector3f dir = rotation.transpose() * ray;
+    float tMin(-1e9f), tMax(1e9f);
+    for(int i=0; i<3; ++i)
+    {
+      if( fabs(dir[i]) < 1e-9f )
+      {
+        if( fabs(origin[i]) > halfSize[i] )
+        {
+          return -1.f;
+        }
+        continue;
+      }
+      float t0 = (-halfSize[i] - origin[i]) / dir[i];
+      float t1 = (halfSize[i] - origin[i]) / dir[i];
+      tMin = std::max(tMin, std::min(t0, t1));
+      tMax = std::min(tMax, std::max(t0, t1));
+    }
+    return (tMin <= tMax && tMin > 0.f) ? tMin : -1.f;
+  }
+
+  //! Area of the box surface
+  float area() const
+  {
+    return 8.f * (halfSize[0]*halfSize[1] + halfSize[1]*halfSize[2] + halfSize[0]*halfSize[2]);
+  }
+
+  //! Returns a uniformly distributed point on the box surface
+  Eigen::Vector3f sample() const;
+
+  //! Returns the color at a point on the box surface with a gradient along the box
+  float shade(const Eigen::Vector3f& p) const;
+};
+
+//! converts rgb-ints to the pcl-float for storing rgb-values
+inline float createPCLRGBfromInt(int r, int g, int b)
+{
+  int32_t rgb = (r << 16) | (g << 8) | b;
+  return *(float *)(&rgb);
+}
+
+inline float uniform()
+{
+  return (float) rand() / (float) RAND_MAX;
+}
+
+//! Normal distributed random number via the Box-Muller transform
+inline float gaussian(float sigma)
+{
+  float u = std::max(uniform(), 1e-7f);
+  return sigma * sqrt(-2.f * log(u)) * cos(2.f * (float) M_PI * uniform());
+}
+
+Eigen::Vector3f Box::sample() const
+{
+  const float faces[3] = { halfSize[1]*halfSize[2], halfSize[0]*halfSize[2], halfSize[0]*halfSize[1] };
+  float choice = uniform() * (faces[0] + faces[1] + faces[2]);
+  int axis = (choice < faces[0]) ? 0 : ((choice < faces[0] + faces[1]) ? 1 : 2);
+  Eigen::Vector3f local;
+  for(int i=0; i<3; ++i)
+  {
+    local[i] = (2.f * uniform() - 1.f) * halfSize[i];
+  }
+  local[axis] = (uniform() < 0.5f) ? -halfSize[axis] : halfSize[axis];
+  return center + rotation * local;
+}
+
+float Box::shade(const Eigen::Vector3f& p) const
+{
+  const Eigen::Vector3f local = rotation.transpose() * (p - center);
+  int rgb[3];
+  for(int i=0; i<3; ++i)
+  {
+    float gradient = (halfSize[i] > 0.f) ? 0.25f * local[i] / halfSize[i] : 0.f;
+    rgb[i] = std::min(std::max((int) ((float) color[i] * (1.f + gradient)), 0), 255);
+  }
+  return createPCLRGBfromInt(rgb[0], rgb[1], rgb[2]);
+}
+
+inline Eigen::Matrix3f randomRotation()
+{
+  return Eigen::Matrix3f(Eigen::AngleAxisf(2.f * (float) M_PI * uniform(), Eigen::Vector3f::UnitY()) * Eigen::AngleAxisf((float) M_PI * uniform(), Eigen::Vector3f::UnitX()));
+}
+
+/**
+ * Creates the boxes of a synthetic scene in front of a sensor at the origin looking along the z-axis:
+ * plane: A wall only
+ * cubes: Wall, floor and three rotated cubes
+ * clutter: Wall, floor and 40 boxes of random size and orientation
+ */
+bool createScene(const std::string& name, std::vector<Box>& boxes)
+{
+  const Eigen::Matrix3f identity(Eigen::Matrix3f::Identity());
+  boxes.clear();
+  boxes.push_back(Box(Eigen::Vector3f(0.f, 0.f, 4.f), Eigen::Vector3f(3.f, 2.25f, 0.f), identity, 200, 200, 200));
+  if( name == "plane" )
+  {
+    return true;
+  }
+  boxes.push_back(Box(Eigen::Vector3f(0.f, 1.2f, 2.25f), Eigen::Vector3f(3.f, 0.f, 1.75f), identity, 120, 90, 60));
+  if( name == "cubes" )
+  {
+    const Eigen::Matrix3f rotation(Eigen::AngleAxisf(M_PI_4, Eigen::Vector3f::UnitY()) * Eigen::AngleAxisf(M_PI_4, Eigen::Vector3f::UnitX()));
+    boxes.push_back(Box(Eigen::Vector3f(0.f, 0.f, 2.f), Eigen::Vector3f(0.3f, 0.3f, 0.3f), rotation, 220, 40, 40));
+    boxes.push_back(Box(Eigen::Vector3f(-1.f, 0.8f, 2.5f), Eigen::Vector3f(0.2f, 0.2f, 0.2f), identity, 40, 220, 40));
+    boxes.push_back(Box(Eigen::Vector3f(1.f, 0.6f, 3.f), Eigen::Vector3f(0.4f, 0.4f, 0.4f), rotation.transpose(), 40, 40, 220));
+    return true;
+  }
+  if( name == "clutter" )
+  {
+    for(unsigned i=0; i<40; ++i)
+    {
+      Eigen::Vector3f center((uniform() - 0.5f) * 3.f, (uniform() - 0.5f) * 2.f, 1.5f + uniform() * 2.f);
+      Eigen::Vector3f halfSize(0.03f + uniform() * 0.2f, 0.03f + uniform() * 0.2f, 0.03f + uniform() * 0.2f);
+      boxes.push_back(Box(center, halfSize, randomRotation(), rand() % 256, rand() % 256, rand() % 256));
+    }
+    return true;
+  }
+  return false;
+}
+
+/**
+ * Renders the scene with a depth camera of roughly the given number of pixels and an aspect ratio of 4:3.
+ * Noise is added along the viewing ray.
+ */
+PointCloud::Ptr renderOrganized(const std::vector<Box>& boxes, unsigned points, float noise)
+{
+  PointCloud::Ptr cloud(new PointCloud);
+  const unsigned height = std::max((unsigned) (sqrt(0.75 * (double) points) + 0.5), 1u);
+  const unsigned width = std::max((points + height / 2) / height, 1u);
+  cloud->points.resize(width * height);
+  cloud->width = width;
+  cloud->height = height;
+
+  const float focalLength = 525.f * (float) width / 640.f;
+  for(unsigned v=0; v<height; ++v)
+  {
+    for(unsigned u=0; u<width; ++u)
+    {
+      const Eigen::Vector3f ray(((float) u - 0.5f * (float) width) / focalLength, ((float) v - 0.5f * (float) height) / focalLength, 1.f);
+      float depth(-1.f);
+      unsigned hit(0);
+      for(unsigned i=0; i<boxes.size(); ++i)
+      {
+        float t = boxes[i].intersect(ray);
+        if( t > 0.f && (depth < 0.f || t < depth) )
+        {
+          depth = t;
+          hit = i;
+        }
+      }
+      pcl::PointXYZRGB& p = cloud->points[v * width + u];
+      if( depth < 0.f )
+      {
+        p.x = p.y = p.z = std::numeric_limits<float>::quiet_NaN();
+        cloud->is_dense = false;
+        continue;
+      }
+      const Eigen::Vector3f surface = ray * depth;
+      const Eigen::Vector3f point = ray * (depth + gaussian(noise));
+      p.x = point[0];
+      p.y = point[1];
+      p.z = point[2];
+      p.rgb = boxes[hit].shade(surface);
+    }
+  }
+  return cloud;
+}
+
+/**
+ * Samples the given number of points uniformly from the surfaces of all boxes, visible or not.
+ * Noise is added isotropically.
+ */
+PointCloud::Ptr sampleUnorganized(const std::vector<Box>& boxes, unsigned points, float noise)
+{
+  PointCloud::Ptr cloud(new PointCloud);
+  cloud->points.resize(points);
+  cloud->width = points;
+  cloud->height = 1;
+
+  std::vector<float> areas(boxes.size());
+  float totalArea(0.f);
+  for(unsigned i=0; i<boxes.size(); ++i)
+  {
+    totalArea += boxes[i].area();
+    areas[i] = totalArea;
+  }
+  for(unsigned j=0; j<points; ++j)
+  {
+    unsigned i = std::lower_bound(areas.begin(), areas.end(), uniform() * totalArea) - areas.begin();
+    i = std::min(i, (unsigned) boxes.size() - 1);
+    const Eigen::Vector3f surface = boxes[i].sample();
+    pcl::PointXYZRGB& p = cloud->points[j];
+    p.x = surface[0] + gaussian(noise);
+    p.y = surface[1] + gaussian(noise);
+    p.z = surface[2] + gaussian(noise);
+    p.rgb = boxes[i].shade(surface);
+  }
+  return cloud;
+}
+
+//! Linear interpolated percentile of sorted values
+double percentile(const std::vector<double>& sorted, double p)
+{
+  if( sorted.empty() )
+  {
+    return 0.0;
+  }
+  double rank = p * (double) (sorted.size() - 1);
+  std::size_t lower = (std::size_t) floor(rank);
+  std::size_t upper = std::min(lower + 1, sorted.size() - 1);
+  return sorted[lower] + (rank - (double) lower) * (sorted[upper] - sorted[lower]);
+}
+
+//! Peak resident set size of the process in kilobytes
+long peakMemory()
+{
+  struct rusage usage;
+  if( getrusage(RUSAGE_SELF, &usage) != 0 )
+  {
+    return -1;
+  }
+  return usage.ru_maxrss;
+}
+
+std::string escape(const std::string& s)
+{
+  std::string ret;
+  for(unsigned i=0; i<s.size(); ++i)
+  {
+    if( s[i] == '"' || s[i] == '\\' )
+    {
+      ret += '\\';
+    }
+    ret += s[i];
+  }
+  return ret;
+}
+
+//! Splits a comma separated list
+std::vector<std::string> split(const std::string& s)
+{
+  std::vector<std::string> ret;
+  std::stringstream stream(s);
+  std::string item;
+  while( std::getline(stream, item, ',') )
+  {
+    if( !item.empty() )
+    {
+      ret.push_back(item);
+    }
+  }
+  return ret;
+}
+
+/**
+ * A single benchmark case, either synthetic or loaded from a pcd-file
+ */
+struct Scene
+{
+  std::string name, layout;
+  unsigned points;
+  float noise;
+  PointCloud::Ptr cloud;
+};
+
+/**
+ * Runs a scene and writes its results as json object
+ */
+bool runScene(const Scene& scene, unsigned warmup, unsigned repetitions, int threads, bool organizedNormals, std::ostream& out)
+{
+  sure::SUREFeatureExtractor sure;
+  if( !scene.cloud->isOrganized() )
+  {
+    // the range image requires an organized point cloud
+    sure.config.AdditionalPointsOnDepthBorders = false;
+    sure.config.IgnoreBackgroundDetections = false;
+    sure.config.IgnoreNormalsOnBackgroundDepthBorders = false;
+  }
+  sure.config.NumberOfThreads = threads;
+  sure.config.OrganizedNormalEstimation = organizedNormals;
+  sure.setInputCloud(scene.cloud);
+
+  std::vector<double> latencies[NUMBER_OF_STAGES];
+  double cpuTime[NUMBER_OF_STAGES] = { 0.0 };
+  bool ret(true);
+  for(unsigned r=0; r<warmup+repetitions; ++r)
+  {
+    ret &= sure.calculateSURE();
+    if( r < warmup )
+    {
+      continue;
+    }
+    const sure::Statistics& statistics = sure.statistics;
+    for(int s=0; s<NUMBER_OF_STAGES; ++s)
+    {
+      const sure::Timing& time = (s == TOTAL) ? statistics.total : statistics.stages[s];
+      latencies[s].push_back(time.wall);
+      cpuTime[s] += time.cpu / (double) repetitions;
+    }
+  }
+
+  const double percentiles[] = { 0.5, 0.9, 0.99 };
+  const char* percentileNames[] = { "p50", "p90", "p99" };
+
+  out << "    {\n";
+  out << "      \"scene\": \"" << escape(scene.name) << "\",\n";
+  out << "      \"layout\": \"" << scene.layout << "\",\n";
+  out << "      \"points\": " << scene.cloud->size() << ",\n";
+  out << "      \"noise\": " << scene.noise << ",\n";
+  out << "      \"success\": " << (ret ? "true" : "false") << ",\n";
+  out << "      \"keypoints\": " << sure.statistics.keypoints << ",\n";
+  out << "      \"features\": " << sure.features.size() << ",\n";
+  out << "      \"normals\": " << sure.statistics.normals << ",\n";
+  out << "      \"image_normals\": " << sure.statistics.imageNormals << ",\n";
+  out << "      \"latency_ms\": {\n";
+  for(int s=0; s<NUMBER_OF_STAGES; ++s)
+  {
+    std::vector<double>& sorted = latencies[s];
+    std::sort(sorted.begin(), sorted.end());
+    double mean(0.0);
+    for(unsigned i=0; i<sorted.size(); ++i)
+    {
+      mean += sorted[i];
+    }
+    mean /= (double) std::max((std::size_t) 1, sorted.size());
+    const char* name = (s == TOTAL) ? "total" : sure::Statistics::getStageName((sure::Statistics::Stage) s);
+    out << "        \"" << name << "\": { \"min\": " << (sorted.empty() ? 0.0 : sorted.front()) << ", \"mean\": " << mean;
+    for(unsigned p=0; p<3; ++p)
+    {
+      out << ", \"" << percentileNames[p] << "\": " << percentile(sorted, percentiles[p]);
+    }
+    out << ", \"max\": " << (sorted.empty() ? 0.0 : sorted.back()) << ", \"cpu_mean\": " << cpuTime[s] << " }" << (s < NUMBER_OF_STAGES-1 ? ",\n" : "\n");
+  }
+  out << "      },\n";
+  double median = percentile(latencies[TOTAL], 0.5);
+  out << "      \"points_per_second\": " << (median > 0.0 ? (double) scene.cloud->size() / (median * 0.001) : 0.0) << ",\n";
+  out << "      \"octree_nodes\": " << sure.statistics.allocatorHighWaterMark << ",\n";
+  out << "      \"octree_memory_bytes\": " << sure.statistics.allocatorMemory << ",\n";
+  out << "      \"peak_rss_kb\": " << peakMemory() << "\n";
+  out << "    }";
+  return ret;
+}
+
+void printUsage(const char* name)
+{
+  std::cerr << "Usage: " << name << " [options]\n"
+            << "  --scenes LIST       comma separated synthetic scenes out of plane,cubes,clutter (default: all)\n"
+            << "  --points LIST       comma separated number of points (default: 100000,1000000,5000000)\n"
+            << "  --noise LIST        comma separated standard deviation of the noise in meters (default: 0,0.005)\n"
+            << "  --layouts LIST      comma separated point cloud layouts out of organized,unorganized (default: both)\n"
+            << "  --pcd FILE          adds a recorded scene from a pcd-file, may be given multiple times\n"
+            << "  --synthetic 0|1     enables the synthetic scenes (default: 1)\n"
+            << "  --repetitions N     measured runs per scene (default: 5)\n"
+            << "  --warmup N          unmeasured runs per scene (default: 1)\n"
+            << "  --threads N         number of worker threads, 0 uses all available (default: 0)\n"
+            << "  --organized-normals 0|1  integrates normals of organized clouds with integral images (default: 0)\n"
+            << "  --output FILE       writes the json report to a file instead of stdout\n";
+}
+
+/**
+ * Runs the full feature extraction on parametrized synthetic scenes and recorded point clouds.
+ * Scenes are run in ascending number of points, since the peak memory is measured for the whole process.
+ */
+int main(int argc, char** argv)
+{
+  std::vector<std::string> sceneNames = split("plane,cubes,clutter");
+  std::vector<std::string> pointList = split("100000,1000000,5000000");
+  std::vector<std::string> noiseList = split("0,0.005");
+  std::vector<std::string> layouts = split("organized,unorganized");
+  std::vector<std::string> pcdFiles;
+  bool synthetic(true);
+  unsigned repetitions(5), warmup(1);
+  int threads(0);
+  bool organizedNormals(false);
+  std::string output;
+
+  for(int i=1; i<argc; ++i)
+  {
+    std::string arg(argv[i]);
+    if( arg == "--help" || arg == "-h" || i+1 >= argc )
+    {
+      printUsage(argv[0]);
+      return arg == "--help" || arg == "-h" ? 0 : 1;
+    }
+    std::string value(argv[++i]);
+    if( arg == "--scenes" )
+    {
+      sceneNames = split(value);
+    }
+    else if( arg == "--points" )
+    {
+      pointList = split(value);
+    }
+    else if( arg == "--noise" )
+    {
+      noiseList = split(value);
+    }
+    else if( arg == "--layouts" )
+    {
+      layouts = split(value);
+    }
+    else if( arg == "--pcd" )
+    {
+      pcdFiles.push_back(value);
+    }
+    else if( arg == "--synthetic" )
+    {
+      synthetic = atoi(value.c_str()) != 0;
+    }
+    else if( arg == "--repetitions" )
+    {
+      repetitions = std::max(atoi(value.c_str()), 1);
+    }
+    else if( arg == "--warmup" )
+    {
+      warmup = std::max(atoi(value.c_str()), 0);
+    }
+    else if( arg == "--threads" )
+    {
+      threads = atoi(value.c_str());
+    }
+    else if( arg == "--organized-normals" )
+    {
+      organizedNormals = atoi(value.c_str()) != 0;
+    }
+    else if( arg == "--output" )
+    {
+      output = value;
+    }
+    else
+    {
+      printUsage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::vector<unsigned> points;
+  for(unsigned i=0; i<pointList.size(); ++i)
+  {
+    points.push_back(strtoul(pointList[i].c_str(), NULL, 10));
+  }
+  std::sort(points.begin(), points.end());
+
+  std::ofstream file;
+  if( !output.empty() )
+  {
+    file.open(output.c_str());
+    if( !file )
+    {
+      std::cerr << "Cannot open " << output << "\n";
+      return 1;
+    }
+  }
+  // the library reports diagnostics on std::cout, they must not end up in the json report
+  std::ostream out(output.empty() ? std::cout.rdbuf() : file.rdbuf());
+  std::streambuf* coutBuffer = std::cout.rdbuf(std::cerr.rdbuf());
+  out << std::setprecision(6);
+
+  out << "{\n";
+  out << "  \"benchmark\": \"sure_bench\",\n";
+  out << "  \"threads\": " << sure::getNumberOfThreads(threads) << ",\n";
+  out << "  \"organized_normals\": " << (organizedNormals ? "true" : "false") << ",\n";
+  out << "  \"repetitions\": " << repetitions << ",\n";
+  out << "  \"warmup\": " << warmup << ",\n";
+  out << "  \"results\": [\n";
+
+  bool ret(true), first(true);
+  for(unsigned i=0; i<pcdFiles.size(); ++i)
+  {
+    Scene scene;
+    scene.name = pcdFiles[i];
+    scene.cloud.reset(new PointCloud);
+    if( pcl::io::loadPCDFile(pcdFiles[i], *scene.cloud) < 0 )
+    {
+      std::cerr << "Cannot load " << pcdFiles[i] << "\n";
+      ret = false;
+      continue;
+    }
+    scene.layout = scene.cloud->isOrganized() ? "organized" : "unorganized";
+    scene.points = scene.cloud->size();
+    scene.noise = 0.f;
+    out << (first ? "" : ",\n");
+    first = false;
+    std::cerr << "Running " << scene.name << "\n";
+    ret &= runScene(scene, warmup, repetitions, threads, organizedNormals, out);
+  }
+
+  for(unsigned p=0; synthetic && p<points.size(); ++p)
+  {
+    for(unsigned s=0; s<sceneNames.size(); ++s)
+    {
+      for(unsigned n=0; n<noiseList.size(); ++n)
+      {
+        for(unsigned l=0; l<layouts.size(); ++l)
+        {
+          Scene scene;
+          scene.name = sceneNames[s];
+          scene.layout = layouts[l];
+          scene.points = points[p];
+          scene.noise = atof(noiseList[n].c_str());
+
+          std::vector<Box> boxes;
+          // the same scene for every layout and noise level
+          srand(42);
+          if( !createScene(scene.name, boxes) || (scene.layout != "organized" && scene.layout != "unorganized") )
+          {
+            std::cerr << "Unknown scene " << scene.name << " or layout " << scene.layout << "\n";
+            ret = false;
+            continue;
+          }
+          scene.cloud = (scene.layout == "organized") ? renderOrganized(boxes, scene.points, scene.noise) : sampleUnorganized(boxes, scene.points, scene.noise);
+
+          out << (first ? "" : ",\n");
+          first = false;
+          std::cerr << "Running " << scene.name << ", " << scene.layout << ", " << scene.points << " points, noise " << scene.noise << "\n";
+          ret &= runScene(scene, warmup, repetitions, threads, organizedNormals, out);
+        }
+      }
+    }
+  }
+  out << "\n  ]\n}\n";
+  out.flush();
+  std::cout.rdbuf(coutBuffer);
+  return ret ? 0 : 1;
+}